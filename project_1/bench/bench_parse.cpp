@@ -0,0 +1,68 @@
+// bench_parse.cpp -- время разбора одного ip-адреса
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <vector>
+
+#include "../ip_parser.hpp"
+#include "data_gen.hpp"
+// Прежний способ: split + std::isdigit + std::stoi, код без изменений
+#include "../tests/functions.cpp"
+
+// Случайные адреса в текстовом виде
+static std::vector<std::string> randomTexts(std::size_t size) {
+   std::vector<std::string> result{};
+   result.reserve(size);
+   for (const auto& ip : randomAddresses(size)) {
+      result.push_back(ip.toString());
+   }
+   return result;
+}
+
+// Время на один адрес, выводится с приставкой: 38.5n -- 38.5 нс
+static void setTimePerAddress(benchmark::State& state, std::size_t size) {
+   state.counters["time_per_address"] = benchmark::Counter(
+      static_cast<double>(size),
+      benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+static void parseSplitStoi(benchmark::State& state) {
+   const auto addresses = randomTexts(10'000);
+   for (auto _ : state) {
+      for (const auto& text : addresses) {
+         auto octets = split(text, '.');
+         if (!invalidIP(octets)) {
+            benchmark::DoNotOptimize(makeIP(octets));
+         }
+      }
+   }
+   setTimePerAddress(state, addresses.size());
+}
+BENCHMARK(parseSplitStoi);
+
+static void parseScalar(benchmark::State& state) {
+   const auto addresses = randomTexts(10'000);
+   for (auto _ : state) {
+      for (const auto& text : addresses) {
+         benchmark::DoNotOptimize(parseIPScalar(text));
+      }
+   }
+   setTimePerAddress(state, addresses.size());
+}
+BENCHMARK(parseScalar);
+
+static void parseSwar(benchmark::State& state) {
+   const auto addresses = randomTexts(10'000);
+   for (auto _ : state) {
+      for (const auto& text : addresses) {
+         benchmark::DoNotOptimize(parseIP(text));
+      }
+   }
+   setTimePerAddress(state, addresses.size());
+}
+BENCHMARK(parseSwar);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,238 @@
+// bench_pipeline.cpp -- этапы обработки ip_filter на синтетических данных:
+// разбор строк, проверка адресов, сортировка, каждый фильтр и вывод.
+// Прежний строковый вариант (split, invalidIP, compareIP из
+// tests/functions.cpp) сравнивается с упакованными адресами
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../ip_filters.hpp"
+#include "../ip_index.hpp"
+#include "../ip_output.hpp"
+#include "../ip_reader.hpp"
+#include "../ip_simd.hpp"
+#include "../ip_sort.hpp"
+#include "data_gen.hpp"
+// Прежние split, invalidIP и compareIP
+#include "../tests/functions.cpp"
+
+// Прежняя проверка адреса без изменений. Пустой октет ("1..2.3") она не
+// проверяет, и std::stoi бросает исключение: прежняя программа на такой
+// строке завершалась. В замерах строка считается некорректной
+static bool invalidLegacy(const std::vector<std::string>& octets) {
+   try {
+      return invalidIP(octets);
+   }
+   catch (const std::invalid_argument&) {
+      return true;
+   }
+}
+
+// Синтетические строки заданного числа, state.range(0)
+static std::string linesFor(const benchmark::State& state) {
+   DataShape shape{};
+   shape.lines = static_cast<std::size_t>(state.range(0));
+   return generateLines(shape);
+}
+
+// Первые поля строк
+static std::vector<std::string> firstFields(const std::string& text) {
+   std::vector<std::string> fields{};
+   std::istringstream input{text};
+   for (std::string line; std::getline(input, line);) {
+      fields.emplace_back(firstField(line));
+   }
+   return fields;
+}
+
+// Упакованный отсортированный пул
+static std::vector<IpAddress> sortedPool(const std::string& text) {
+   std::vector<IpAddress> pool{};
+   parseBuffer(text, pool);
+   sortIP(pool, SortEngine::radix);
+   return pool;
+}
+
+static void setLines(benchmark::State& state) {
+   state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Разбор строк: прежний split по табуляции и по точкам
+static void splitLines(benchmark::State& state) {
+   const std::string text{linesFor(state)};
+   for (auto _ : state) {
+      std::istringstream input{text};
+      std::size_t octets{};
+      for (std::string line; std::getline(input, line);) {
+         octets += split(split(line, '\t').at(0), '.').size();
+      }
+      benchmark::DoNotOptimize(octets);
+   }
+   state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(text.size()));
+   setLines(state);
+}
+
+// Разбор строк на месте с проверкой адресов
+static void parseLines(benchmark::State& state) {
+   const std::string text{linesFor(state)};
+   std::vector<IpAddress> pool{};
+   for (auto _ : state) {
+      pool.clear();
+      parseBuffer(text, pool);
+      benchmark::DoNotOptimize(pool.data());
+   }
+   state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(text.size()));
+   setLines(state);
+}
+
+// Проверка адресов: прежний invalidIP по частям
+static void validateSplit(benchmark::State& state) {
+   const auto fields = firstFields(linesFor(state));
+   for (auto _ : state) {
+      std::size_t valid{};
+      for (const auto& field : fields) {
+         valid += !invalidLegacy(split(field, '.'));
+      }
+      benchmark::DoNotOptimize(valid);
+   }
+   setLines(state);
+}
+
+// Проверка адресов: разбор parseIP
+static void validateParse(benchmark::State& state) {
+   const auto fields = firstFields(linesFor(state));
+   for (auto _ : state) {
+      std::size_t valid{};
+      for (const auto& field : fields) {
+         valid += parseIP(field).has_value();
+      }
+      benchmark::DoNotOptimize(valid);
+   }
+   setLines(state);
+}
+
+// Сортировка строковых адресов прежним compareIP
+static void sortCompareIP(benchmark::State& state) {
+   std::vector<std::vector<std::string>> source{};
+   for (const auto& field : firstFields(linesFor(state))) {
+      auto octets = split(field, '.');
+      if (!invalidLegacy(octets)) source.push_back(std::move(octets));
+   }
+   std::vector<std::vector<std::string>> pool{};
+   for (auto _ : state) {
+      state.PauseTiming();
+      pool = source;
+      state.ResumeTiming();
+      std::ranges::sort(pool, compareIP);
+      benchmark::DoNotOptimize(pool.data());
+   }
+   setLines(state);
+}
+
+// Сортировка упакованных адресов
+static void sortPacked(benchmark::State& state, SortEngine engine) {
+   std::vector<IpAddress> source{};
+   parseBuffer(linesFor(state), source);
+   std::vector<IpAddress> pool{};
+   for (auto _ : state) {
+      state.PauseTiming();
+      pool = source;
+      state.ResumeTiming();
+      sortIP(pool, engine);
+      benchmark::DoNotOptimize(pool.data());
+   }
+   setLines(state);
+}
+
+// Фильтр просмотром всего пула
+template<typename Filter>
+static void filterScan(benchmark::State& state, Filter filter) {
+   const auto pool = sortedPool(linesFor(state));
+   for (auto _ : state) {
+      IndexList found{};
+      for (std::size_t i{}; i < pool.size(); ++i) {
+         if (filter(pool[i])) found.push_back(i);
+      }
+      benchmark::DoNotOptimize(found.data());
+   }
+   setLines(state);
+}
+
+// Фильтр по префиксу через индекс
+template<std::size_t N>
+static void filterIndex(benchmark::State& state, PrefixFilter<N> filter) {
+   const auto pool = sortedPool(linesFor(state));
+   const PrefixIndex index{pool};
+   for (auto _ : state) {
+      benchmark::DoNotOptimize(index.find(filter).size());
+   }
+   setLines(state);
+}
+
+// Фильтр по любому байту векторным ядром
+static void filterAnySimd(benchmark::State& state) {
+   const auto pool = sortedPool(linesFor(state));
+   for (auto _ : state) {
+      IndexList found{filterAnyByte(pool, filter_any(46))};
+      benchmark::DoNotOptimize(found.data());
+   }
+   setLines(state);
+}
+
+// Вывод через std::ostream, как прежний displayIP
+static void outputStream(benchmark::State& state) {
+   const auto pool = sortedPool(linesFor(state));
+   std::ofstream output{"/dev/null"};
+   for (auto _ : state) {
+      for (IpAddress ip : pool) {
+         output << ip << '\n';
+      }
+      output.flush();
+   }
+   setLines(state);
+}
+
+// Вывод через буфер IpWriter
+static void outputWriter(benchmark::State& state) {
+   const auto pool = sortedPool(linesFor(state));
+   int fd{::open("/dev/null", O_WRONLY | O_CLOEXEC)};
+   for (auto _ : state) {
+      IpWriter out{fd};
+      out.write(pool);
+   }
+   ::close(fd);
+   setLines(state);
+}
+
+// Объёмы данных: ip_filter.tsv, в 100 и в 10000 раз больше
+static void lines(benchmark::internal::Benchmark* bench) {
+   bench->Arg(1'000)->Arg(100'000)->Arg(10'000'000)
+      ->Unit(benchmark::kMicrosecond);
+}
+
+BENCHMARK(splitLines)->Apply(lines);
+BENCHMARK(parseLines)->Apply(lines);
+BENCHMARK(validateSplit)->Apply(lines);
+BENCHMARK(validateParse)->Apply(lines);
+BENCHMARK(sortCompareIP)->Arg(1'000)->Arg(100'000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(sortPacked, comparison, SortEngine::comparison)->Apply(lines);
+BENCHMARK_CAPTURE(sortPacked, radix, SortEngine::radix)->Apply(lines);
+BENCHMARK_CAPTURE(filterScan, first_byte, filter(1))->Apply(lines);
+BENCHMARK_CAPTURE(filterScan, first_two_bytes, filter(46, 70))->Apply(lines);
+BENCHMARK_CAPTURE(filterScan, any_byte, filter_any(46))->Apply(lines);
+BENCHMARK_CAPTURE(filterIndex, first_byte, filter(1))->Apply(lines);
+BENCHMARK_CAPTURE(filterIndex, first_two_bytes, filter(46, 70))->Apply(lines);
+BENCHMARK(filterAnySimd)->Apply(lines);
+BENCHMARK(outputStream)->Apply(lines);
+BENCHMARK(outputWriter)->Apply(lines);
+
+BENCHMARK_MAIN();
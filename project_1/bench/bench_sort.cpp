@@ -0,0 +1,54 @@
+// bench_sort.cpp -- сравнение сортировки сравнением и поразрядной сортировки,
+// масштабирование параллельной сортировки по числу потоков
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "../ip_sort.hpp"
+#include "data_gen.hpp"
+
+// Сортировка пула выбранным способом.
+// Копия исходного пула восстанавливается вне замера времени
+static void sortBenchmark(benchmark::State& state, SortEngine engine) {
+   const auto source = randomAddresses(static_cast<std::size_t>(state.range(0)));
+   std::vector<IpAddress> pool{};
+   for (auto _ : state) {
+      state.PauseTiming();
+      pool = source;
+      state.ResumeTiming();
+      sortIP(pool, engine);
+      benchmark::DoNotOptimize(pool.data());
+   }
+   state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_CAPTURE(sortBenchmark, comparison, SortEngine::comparison)
+   ->Arg(100'000)->Arg(10'000'000)->Arg(100'000'000)
+   ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(sortBenchmark, radix, SortEngine::radix)
+   ->Arg(100'000)->Arg(10'000'000)->Arg(100'000'000)
+   ->Unit(benchmark::kMillisecond);
+
+// Параллельная сортировка пула в state.range(1) потоков
+static void parallelSortBenchmark(benchmark::State& state) {
+   const auto source = randomAddresses(static_cast<std::size_t>(state.range(0)));
+   const auto threads = static_cast<unsigned>(state.range(1));
+   std::vector<IpAddress> pool{};
+   for (auto _ : state) {
+      state.PauseTiming();
+      pool = source;
+      state.ResumeTiming();
+      sortIP(pool, SortEngine::parallel, threads);
+      benchmark::DoNotOptimize(pool.data());
+   }
+   state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Отчёт о масштабировании: 1e8 адресов в 1-32 потоках
+BENCHMARK(parallelSortBenchmark)
+   ->ArgsProduct({{100'000'000}, {1, 2, 4, 8, 16, 32}})
+   ->ArgNames({"size", "threads"})
+   ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,28 @@
+// generate_data.cpp -- синтетический входной файл для ip_filter
+// Запуск: ./generate_data ЧИСЛО_СТРОК [ЗЕРНО] > data.tsv
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "data_gen.hpp"
+
+int main(int argc, char* argv[]) {
+   if (argc < 2) {
+      std::cerr << "Запуск: " << argv[0] << " ЧИСЛО_СТРОК [ЗЕРНО]\n";
+      return 1;
+   }
+   DataShape shape{};
+   // Строки выдаются порциями, чтобы не держать в памяти весь файл
+   constexpr std::size_t portion{1'000'000};
+   std::size_t left{std::stoull(argv[1])};
+   shape.seed = argc > 2 ? static_cast<std::uint32_t>(std::stoul(argv[2])) : 42;
+   while (left != 0) {
+      shape.lines = std::min(left, portion);
+      std::string text{generateLines(shape)};
+      std::fwrite(text.data(), 1, text.size(), stdout);
+      left -= shape.lines;
+      ++shape.seed;
+   }
+}
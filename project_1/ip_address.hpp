@@ -0,0 +1,79 @@
+// ip_address.hpp -- компактное представление IPv4-адреса
+
+#pragma once
+
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// IPv4-адрес, упакованный в 4 байта.
+// Первый октет хранится в старшем байте (big-endian порядок октетов),
+// поэтому лексикографический порядок адресов совпадает с порядком чисел.
+class IpAddress {
+private:
+   std::uint32_t m_value; // Упакованное значение адреса
+public:
+   // Конструктор по умолчанию -- адрес 0.0.0.0
+   constexpr IpAddress() noexcept : m_value{} {}
+
+   // Конструктор из упакованного значения
+   constexpr explicit IpAddress(std::uint32_t value) noexcept
+      : m_value{value} {}
+
+   // Конструктор из отдельных октетов n1.n2.n3.n4
+   constexpr IpAddress(std::uint8_t n1, std::uint8_t n2,
+      std::uint8_t n3, std::uint8_t n4) noexcept
+      : m_value{(std::uint32_t{n1} << 24) | (std::uint32_t{n2} << 16)
+         | (std::uint32_t{n3} << 8) | std::uint32_t{n4}} {}
+
+   // Упакованное значение адреса
+   constexpr std::uint32_t value() const noexcept {
+      return m_value;
+   }
+
+   // Октет адреса по индексу [0-3], 0 -- первый (старший) октет
+   constexpr std::uint8_t octet(std::size_t index) const noexcept {
+      return static_cast<std::uint8_t>(m_value >> (24 - 8 * index));
+   }
+
+   // Все октеты адреса по порядку
+   constexpr std::array<std::uint8_t, 4> octets() const noexcept {
+      return {octet(0), octet(1), octet(2), octet(3)};
+   }
+
+   // Текстовое представление адреса в виде n1.n2.n3.n4
+   std::string toString() const {
+      std::string result{};
+      result.reserve(15);
+      for (std::size_t i{}; i < 4; ++i) {
+         if (i != 0) result += '.';
+         result += std::to_string(octet(i));
+      }
+      return result;
+   }
+
+   // Сравнение адресов сводится к сравнению упакованных значений
+   friend constexpr bool operator==(IpAddress, IpAddress) noexcept = default;
+   friend constexpr auto operator<=>(IpAddress, IpAddress) noexcept = default;
+};
+
+static_assert(sizeof(IpAddress) == 4, "IpAddress must occupy 4 bytes");
+
+// Вывод адреса в поток
+inline std::ostream& operator<<(std::ostream& out, IpAddress ip) {
+   return out << ip.toString();
+}
+
+// Упаковка прошедшего проверку адреса из списка октетов-строк.
+// Предполагается, что октетов ровно 4 и каждый лежит в диапазоне [0-255]
+inline IpAddress makeIP(const std::vector<std::string>& octets) {
+   return IpAddress{
+      static_cast<std::uint8_t>(std::stoi(octets[0])),
+      static_cast<std::uint8_t>(std::stoi(octets[1])),
+      static_cast<std::uint8_t>(std::stoi(octets[2])),
+      static_cast<std::uint8_t>(std::stoi(octets[3]))};
+}
@@ -0,0 +1,202 @@
+// ip_aggregate.hpp -- свёртка повторов и суммирование столбцов text2, text3
+
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ip_address.hpp"
+#include "ip_output.hpp"
+#include "ip_parser.hpp"
+#include "ip_reader.hpp"
+#include "ip_sort.hpp"
+
+// Загруженные строки в виде столбцов: адрес и два счётчика строки
+// лежат в отдельных массивах под одним номером строки
+struct AddressColumns {
+   std::vector<IpAddress> addresses;  // Поле text1
+   std::vector<std::uint32_t> text2;  // Поле text2
+   std::vector<std::uint32_t> text3;  // Поле text3
+
+   void push(IpAddress ip, std::uint32_t second, std::uint32_t third) {
+      addresses.push_back(ip);
+      text2.push_back(second);
+      text3.push_back(third);
+   }
+
+   std::size_t size() const noexcept {
+      return addresses.size();
+   }
+};
+
+// Итоги по различным адресам, тоже по столбцам.
+// Адреса идут в обратном лексикографическом порядке
+struct AddressTotals {
+   std::vector<IpAddress> addresses;  // Различные адреса
+   std::vector<std::uint64_t> counts; // Число строк с адресом
+   std::vector<std::uint64_t> text2;  // Сумма поля text2
+   std::vector<std::uint64_t> text3;  // Сумма поля text3
+
+   std::size_t size() const noexcept {
+      return addresses.size();
+   }
+};
+
+// Разбор строки с тремя полями. Строка с некорректным адресом
+// пропускается, отсутствующий или нечисловой счётчик считается нулём.
+// Возвращает false, если адрес не разобран
+inline bool parseRecord(std::string_view line, AddressColumns& columns) {
+   std::uint32_t counters[2]{};
+   std::string_view rest{line};
+   auto nextField = [&rest]() {
+      std::size_t start{rest.find_first_not_of("\t \r")};
+      if (start == std::string_view::npos) {
+         rest = {};
+         return rest;
+      }
+      rest.remove_prefix(start);
+      std::size_t stop{std::min(rest.find_first_of("\t \r"), rest.size())};
+      std::string_view field{rest.substr(0, stop)};
+      rest.remove_prefix(stop);
+      return field;
+   };
+   auto ip = parseIP(nextField());
+   if (!ip) return false;
+   for (std::uint32_t& counter : counters) {
+      std::string_view field{nextField()};
+      auto [end, error] = std::from_chars(field.data(),
+         field.data() + field.size(), counter);
+      if (error != std::errc{} || end != field.data() + field.size()) {
+         counter = 0;
+      }
+   }
+   columns.push(*ip, counters[0], counters[1]);
+   return true;
+}
+
+// Разбирает буфер построчно и добавляет строки в столбцы.
+// input -- если задан, в него добавляются объём и число строк
+inline void parseColumns(std::string_view buffer, AddressColumns& columns,
+   InputStats* input = nullptr) {
+   const char* current{buffer.data()};
+   const char* end{buffer.data() + buffer.size()};
+   while (current < end) {
+      const char* eol = static_cast<const char*>(
+         std::memchr(current, '\n', static_cast<std::size_t>(end - current)));
+      if (!eol) eol = end;
+      std::string_view line{current, static_cast<std::size_t>(eol - current)};
+      bool parsed{parseRecord(line, columns)};
+      if (input) countLine(*input, line, parsed);
+      current = eol + 1;
+   }
+}
+
+// Загрузка столбцов из файла через отображение в память
+inline AddressColumns loadColumns(const std::string& path,
+   InputStats* input = nullptr) {
+   MappedFile file{path};
+   AddressColumns columns{};
+   parseColumns(file.data(), columns, input);
+   return columns;
+}
+
+namespace detail {
+
+// Свёртка отсортированных по убыванию адреса строк. rows -- номера строк
+// в каком-либо представлении, value и index извлекают из элемента адрес
+// и номер строки. Одинаковые адреса идут подряд и сворачиваются одним
+// проходом по сериям
+template<typename Row, typename Value, typename Index>
+AddressTotals collapseRows(const AddressColumns& columns,
+   const std::vector<Row>& rows, Value value, Index index) {
+   AddressTotals totals{};
+   const std::size_t n{rows.size()};
+   for (std::size_t begin{}; begin < n;) {
+      const std::uint32_t address{value(rows[begin])};
+      std::uint64_t second{};
+      std::uint64_t third{};
+      std::size_t end{begin};
+      for (; end < n && value(rows[end]) == address; ++end) {
+         const std::size_t row{index(rows[end])};
+         second += columns.text2[row];
+         third += columns.text3[row];
+      }
+      totals.addresses.emplace_back(address);
+      totals.counts.push_back(end - begin);
+      totals.text2.push_back(second);
+      totals.text3.push_back(third);
+      begin = end;
+   }
+   return totals;
+}
+
+// Свёртка через массив номеров строк std::size_t. Ключ сортировки берётся
+// из столбца адресов по номеру, поэтому она медленнее упакованной, но
+// годится для любого числа строк
+inline AddressTotals aggregateIndexed(const AddressColumns& columns,
+   unsigned threads) {
+   std::vector<std::size_t> rows(columns.size());
+   for (std::size_t row{}; row < rows.size(); ++row) {
+      rows[row] = row;
+   }
+   auto address = [&columns](std::size_t row) {
+      return columns.addresses[row].value();
+   };
+   radixSortDescendingParallel(rows, threads, address);
+   return collapseRows(columns, rows, address,
+      [](std::size_t row) { return row; });
+}
+
+} // namespace detail
+
+// Свёртка повторов. Пары "адрес -- номер строки" упакованы в 64-битные
+// слова и сортируются поразрядно по адресу в старшей половине, сами
+// столбцы не переставляются (номер строки -- младшие 32 бита). После
+// сортировки одинаковые адреса идут подряд и сворачиваются одним проходом
+// по сериям. Номер строки от 2^32 в младшую половину не помещается, такие
+// объёмы сворачиваются через массив номеров строк std::size_t.
+// threads -- число потоков сортировки
+inline AddressTotals aggregate(const AddressColumns& columns,
+   unsigned threads = 1) {
+   const std::size_t n{columns.size()};
+   if (n > std::numeric_limits<std::uint32_t>::max()) {
+      return detail::aggregateIndexed(columns, threads);
+   }
+   std::vector<std::uint64_t> rows(n);
+   for (std::size_t row{}; row < n; ++row) {
+      rows[row] = std::uint64_t{columns.addresses[row].value()} << 32 | row;
+   }
+   auto address = [](std::uint64_t item) {
+      return static_cast<std::uint32_t>(item >> 32);
+   };
+   radixSortDescendingParallel(rows, threads, address);
+   return detail::collapseRows(columns, rows, address, [](std::uint64_t item) {
+      return static_cast<std::size_t>(static_cast<std::uint32_t>(item));
+   });
+}
+
+// Вывод итогов, одна строка на адрес:
+// адрес, число строк, сумма text2 и сумма text3 через табуляцию
+inline void writeTotals(IpWriter& out, const AddressTotals& totals) {
+   // Адрес и три 20-значных числа с разделителями
+   char line[maxLineLength + 3 * 21];
+   for (std::size_t i{}; i < totals.size(); ++i) {
+      char* current{line + formatIP(totals.addresses[i], line)};
+      // formatIP завершает адрес переводом строки, меняем его на табуляцию
+      current[-1] = '\t';
+      for (std::uint64_t value : {totals.counts[i], totals.text2[i],
+            totals.text3[i]}) {
+         current = std::to_chars(current, line + sizeof(line), value).ptr;
+         *current++ = '\t';
+      }
+      current[-1] = '\n';
+      out.write(std::string_view{line, static_cast<std::size_t>(current - line)});
+   }
+}
@@ -0,0 +1,304 @@
+// ip_external.hpp -- внешняя сортировка пула, не помещающегося в память
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "ip_address.hpp"
+#include "ip_reader.hpp"
+
+// Временный файл с адресами в двоичном виде, по 4 байта на адрес.
+// Файл создаётся уже удалённым и исчезает при закрытии
+class RunFile {
+private:
+   FileHandle m_file;                // Временный файл
+   std::vector<IpAddress> m_pending; // Адреса, ещё не записанные
+   std::size_t m_size;               // Всего адресов в файле
+
+   [[noreturn]] static void fail(const char* what) {
+      throw std::system_error{errno, std::generic_category(), what};
+   }
+public:
+   // bufferSize -- число адресов, накапливаемых перед записью
+   explicit RunFile(std::size_t bufferSize = 4096)
+      : m_file{std::tmpfile()}, m_pending{}, m_size{} {
+         if (!m_file) fail("tmpfile");
+         // Чтение и запись идут крупными блоками, буфер stdio не нужен
+         std::setvbuf(m_file.get(), nullptr, _IONBF, 0);
+         m_pending.reserve(bufferSize);
+   }
+
+   // Запись блока адресов
+   void write(std::span<const IpAddress> addresses) {
+      if (addresses.empty()) return;
+      if (std::fwrite(addresses.data(), sizeof(IpAddress), addresses.size(),
+            m_file.get()) != addresses.size()) {
+         fail("fwrite");
+      }
+      m_size += addresses.size();
+   }
+
+   // Добавление одного адреса через буфер
+   void push(IpAddress ip) {
+      m_pending.push_back(ip);
+      if (m_pending.size() == m_pending.capacity()) flush();
+   }
+
+   // Запись накопленных адресов
+   void flush() {
+      write(m_pending);
+      m_pending.clear();
+   }
+
+   // Переход к чтению с начала файла
+   void rewind() {
+      flush();
+      if (std::fseek(m_file.get(), 0, SEEK_SET) != 0) fail("fseek");
+   }
+
+   // Чтение следующего блока, возвращает число прочитанных адресов
+   std::size_t read(std::span<IpAddress> buffer) {
+      std::size_t count{std::fread(buffer.data(), sizeof(IpAddress),
+         buffer.size(), m_file.get())};
+      if (count < buffer.size() && std::ferror(m_file.get())) fail("fread");
+      return count;
+   }
+
+   // Передаёт все адреса файла по порядку в consumer
+   template<typename Consumer>
+   void forEach(Consumer&& consumer) {
+      rewind();
+      // Буфер записи больше не нужен, его память идёт под чтение
+      std::vector<IpAddress> buffer{std::move(m_pending)};
+      buffer.resize(std::max<std::size_t>(buffer.capacity(), 1));
+      for (std::size_t count; (count = read(buffer)) != 0;) {
+         for (std::size_t i{}; i < count; ++i) {
+            consumer(buffer[i]);
+         }
+      }
+   }
+
+   // Всего адресов в файле
+   std::size_t size() const noexcept {
+      return m_size + m_pending.size();
+   }
+};
+
+// Внешняя сортировка в обратном лексикографическом порядке.
+// Адреса накапливаются порциями, каждая порция сортируется в памяти и
+// сохраняется во временный файл (серию). Одновременно открыто не больше
+// fanIn серий: когда их становится fanIn, последние серии сливаются в одну,
+// как разряды в счётчике по основанию fanIn, так что каждый адрес
+// переписывается O(log_fanIn(серий)) раз. В конце оставшиеся серии
+// сливаются в consumer. Буферы слияния -- части памяти порции, поэтому
+// вместе с учётом серий вся память сортировщика не превышает memoryLimit
+class ExternalSorter {
+public:
+   // Наибольшее число одновременно сливаемых серий по умолчанию
+   static constexpr std::size_t defaultFanIn{64};
+private:
+   // Серия и её уровень: число слияний, через которые прошли её адреса
+   struct Run {
+      RunFile file;
+      std::size_t level;
+   };
+
+   // Голова серии в куче слияния
+   using Head = std::pair<IpAddress, std::size_t>;
+
+   // Наименьший буфер одной серии при слиянии, адресов
+   static constexpr std::size_t minMergeBuffer{256};
+   // Память на учёт одной серии: место в списке серий, голова в куче,
+   // позиция и число адресов в буфере
+   static constexpr std::size_t runOverhead{
+      sizeof(Run) + sizeof(Head) + 2 * sizeof(std::size_t)};
+
+   std::size_t m_fanIn;             // Наибольшее число сливаемых серий
+   std::vector<IpAddress> m_chunk;  // Текущая порция, при слиянии -- буферы
+   std::vector<Run> m_runs;         // Открытые серии, уровни не возрастают
+   std::size_t m_count;             // Всего добавлено адресов
+   std::size_t m_spills;            // Всего сохранено порций
+
+   // Слияние серий начиная с first в consumer. Память порции делится на
+   // slices буферов, первые из них -- буферы чтения сливаемых серий
+   template<typename Consumer>
+   void mergeRuns(std::size_t first, std::size_t slices, Consumer&& consumer) {
+      const std::size_t k{m_runs.size() - first};
+      m_chunk.resize(m_chunk.capacity());
+      const std::size_t bufferSize{m_chunk.size() / slices};
+      std::vector<std::size_t> positions(k);
+      std::vector<std::size_t> counts(k);
+      std::vector<Head> storage{};
+      storage.reserve(k);
+      // Куча из текущих голов серий, сверху наибольший адрес
+      std::priority_queue<Head, std::vector<Head>, std::less<Head>> heads{
+         std::less<Head>{}, std::move(storage)};
+      auto buffer = [&](std::size_t run) {
+         return std::span{m_chunk}.subspan(run * bufferSize, bufferSize);
+      };
+      auto refill = [&](std::size_t run) {
+         counts[run] = m_runs[first + run].file.read(buffer(run));
+         positions[run] = 0;
+         return counts[run] != 0;
+      };
+      for (std::size_t run{}; run < k; ++run) {
+         m_runs[first + run].file.rewind();
+         if (refill(run)) heads.emplace(buffer(run)[0], run);
+      }
+      while (!heads.empty()) {
+         auto [ip, run] = heads.top();
+         heads.pop();
+         consumer(ip);
+         if (++positions[run] < counts[run] || refill(run)) {
+            heads.emplace(buffer(run)[positions[run]], run);
+         }
+      }
+      m_runs.erase(m_runs.begin() + static_cast<std::ptrdiff_t>(first),
+         m_runs.end());
+   }
+
+   // Слияние последних серий в одну, когда открыто fanIn серий.
+   // Сливается последняя группа хотя бы из двух серий одного уровня вместе
+   // с меньшими сериями после неё; если все уровни разные -- две последние
+   void collapse() {
+      std::size_t first{m_runs.size() - 2};
+      for (std::size_t i{m_runs.size() - 1}; i > 0; --i) {
+         if (m_runs[i - 1].level == m_runs[i].level) {
+            first = i - 1;
+            while (first > 0 && m_runs[first - 1].level == m_runs[i].level) --first;
+            break;
+         }
+      }
+      const std::size_t level{m_runs[first].level + 1};
+      const std::size_t slices{m_runs.size() - first + 1};
+      const std::size_t bufferSize{m_chunk.capacity() / slices};
+      RunFile merged{0};
+      // Последний буфер -- буфер записи объединённой серии
+      std::span<IpAddress> output{
+         m_chunk.data() + (slices - 1) * bufferSize, bufferSize};
+      std::size_t used{};
+      mergeRuns(first, slices, [&](IpAddress ip) {
+         output[used++] = ip;
+         if (used == output.size()) {
+            merged.write(output);
+            used = 0;
+         }
+      });
+      merged.write(output.first(used));
+      m_chunk.clear();
+      m_runs.push_back(Run{std::move(merged), level});
+   }
+
+   // Сортировка текущей порции и сохранение её серией
+   void spill() {
+      if (m_chunk.empty()) return;
+      std::ranges::sort(m_chunk, std::ranges::greater{});
+      RunFile run{0};
+      run.write(m_chunk);
+      m_runs.push_back(Run{std::move(run), 0});
+      m_chunk.clear();
+      ++m_spills;
+      if (m_runs.size() == m_fanIn) collapse();
+   }
+public:
+   // memoryLimit -- предел памяти в байтах, fanIn -- наибольшее число
+   // сливаемых серий. Если при малом пределе на fanIn серий не хватает
+   // буферов, число сливаемых серий уменьшается, но не ниже двух
+   explicit ExternalSorter(std::size_t memoryLimit,
+      std::size_t fanIn = defaultFanIn)
+      : m_fanIn{}, m_chunk{}, m_runs{}, m_count{}, m_spills{} {
+         if (fanIn < 2) {
+            throw std::invalid_argument{"сливается меньше двух серий"};
+         }
+         // При слиянии fanIn серий в одну нужно fanIn + 1 буферов
+         constexpr std::size_t bufferBytes{minMergeBuffer * sizeof(IpAddress)};
+         std::size_t affordable{memoryLimit < bufferBytes ? 0
+            : (memoryLimit - bufferBytes) / (bufferBytes + runOverhead)};
+         m_fanIn = std::min(fanIn, affordable);
+         if (m_fanIn < 2) {
+            throw std::invalid_argument{"слишком маленький предел памяти"};
+         }
+         m_runs.reserve(m_fanIn);
+         m_chunk.reserve(
+            (memoryLimit - m_fanIn * runOverhead) / sizeof(IpAddress));
+   }
+
+   // Добавление адреса
+   void add(IpAddress ip) {
+      if (m_chunk.size() == m_chunk.capacity()) spill();
+      m_chunk.push_back(ip);
+      ++m_count;
+   }
+
+   // Всего добавлено адресов
+   std::size_t size() const noexcept {
+      return m_count;
+   }
+
+   // Число открытых серий во временных файлах, меньше fanIn()
+   std::size_t runs() const noexcept {
+      return m_runs.size();
+   }
+
+   // Всего сохранено порций
+   std::size_t spills() const noexcept {
+      return m_spills;
+   }
+
+   // Наибольшее число сливаемых серий
+   std::size_t fanIn() const noexcept {
+      return m_fanIn;
+   }
+
+   // Передаёт все адреса в consumer по убыванию и освобождает память.
+   // Если все адреса поместились в одну порцию, временные файлы не нужны
+   template<typename Consumer>
+   void merge(Consumer&& consumer) {
+      if (m_runs.empty()) {
+         std::ranges::sort(m_chunk, std::ranges::greater{});
+         for (IpAddress ip : m_chunk) {
+            consumer(ip);
+         }
+      }
+      else {
+         spill();
+         mergeRuns(0, m_runs.size(), consumer);
+      }
+      std::vector<IpAddress>{}.swap(m_chunk);
+      std::vector<Run>{}.swap(m_runs);
+   }
+};
+
+// Разбор предела памяти: число байт с необязательным суффиксом K, M или G
+inline std::size_t parseMemoryLimit(const std::string& text) {
+   // std::stoull принимает знак минус и возвращает огромное значение
+   if (text.empty() || text.front() < '0' || text.front() > '9') {
+      throw std::invalid_argument{"неверный предел памяти " + text};
+   }
+   std::size_t digits{};
+   std::size_t value{std::stoull(text, &digits)};
+   std::string suffix{text.substr(digits)};
+   unsigned shift{};
+   if (suffix == "K" || suffix == "k") shift = 10;
+   else if (suffix == "M" || suffix == "m") shift = 20;
+   else if (suffix == "G" || suffix == "g") shift = 30;
+   else if (!suffix.empty()) {
+      throw std::invalid_argument{"неверный предел памяти " + text};
+   }
+   if (value > (std::numeric_limits<std::size_t>::max() >> shift)) {
+      throw std::out_of_range{"слишком большой предел памяти " + text};
+   }
+   return value << shift;
+}
@@ -0,0 +1,89 @@
+// ip_filters.hpp -- фильтрация пула ip-адресов
+
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "ip_address.hpp"
+
+// Фильтр по первым N октетам адреса.
+// N известно при компиляции, поэтому маска -- константа, и проверка
+// сводится к одному сравнению упакованного адреса по маске
+template<std::size_t N>
+class PrefixFilter {
+   static_assert(N >= 1 && N <= 4, "IPv4 address has 4 octets");
+public:
+   // Маска первых N октетов
+   static constexpr std::uint32_t mask{
+      N == 4 ? 0xFFFFFFFFu : ~(0xFFFFFFFFu >> (8 * N))};
+private:
+   std::uint32_t m_pattern; // Искомые октеты на своих местах, остальное -- 0
+public:
+   // Конструктор из упакованных первых N октетов
+   constexpr explicit PrefixFilter(std::uint32_t pattern) noexcept
+      : m_pattern{pattern} {}
+
+   // Искомый префикс в виде адреса
+   constexpr IpAddress prefix() const noexcept {
+      return IpAddress{m_pattern};
+   }
+
+   constexpr bool operator()(IpAddress ip) const noexcept {
+      return (ip.value() & mask) == m_pattern;
+   }
+};
+
+// Фильтр "любой октет адреса равен byte"
+class AnyByteFilter {
+private:
+   std::uint8_t m_byte; // Искомое значение октета
+public:
+   constexpr explicit AnyByteFilter(std::uint8_t byte) noexcept
+      : m_byte{byte} {}
+
+   // Искомое значение октета
+   constexpr std::uint8_t byte() const noexcept {
+      return m_byte;
+   }
+
+   // Приём "has zero byte" для слова ip ^ (byte * 0x01010101):
+   // совпавший октет обращается в ноль
+   constexpr bool operator()(IpAddress ip) const noexcept {
+      std::uint32_t x{ip.value() ^ (0x01010101u * m_byte)};
+      return ((x - 0x01010101u) & ~x & 0x80808080u) != 0;
+   }
+};
+
+// Значение октета с проверкой диапазона [0-255]. При вычислении во время
+// компиляции исключение становится ошибкой компиляции
+template<std::integral Octet>
+constexpr std::uint8_t octetValue(Octet octet) {
+   if (!std::in_range<std::uint8_t>(octet)) {
+      throw std::out_of_range{"октет вне диапазона 0-255"};
+   }
+   return static_cast<std::uint8_t>(octet);
+}
+
+// filter(1), filter(46, 70) -- фильтр по первым октетам адреса
+template<std::integral... Octets>
+   requires (sizeof...(Octets) >= 1 && sizeof...(Octets) <= 4)
+constexpr PrefixFilter<sizeof...(Octets)> filter(Octets... octets) {
+   std::uint32_t pattern{};
+   ((pattern = (pattern << 8) | octetValue(octets)), ...);
+   pattern <<= 8 * (4 - sizeof...(Octets));
+   return PrefixFilter<sizeof...(Octets)>{pattern};
+}
+
+// filter_any(46) -- фильтр по любому октету адреса
+template<std::integral Octet>
+constexpr AnyByteFilter filter_any(Octet byte) {
+   return AnyByteFilter{octetValue(byte)};
+}
+
+// Список позиций адресов в пуле, прошедших фильтр
+using IndexList = std::vector<std::size_t>;
@@ -0,0 +1,203 @@
+// ip_incremental.hpp -- дополнение отсортированного пула новыми адресами
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include "ip_address.hpp"
+#include "ip_filters.hpp"
+#include "ip_snapshot.hpp"
+#include "ip_sort.hpp"
+
+namespace detail {
+
+// Слияние отсортированного по убыванию delta в отсортированный по убыванию
+// base на месте: base удлиняется, слияние идёт с конца, поэтому
+// дополнительная память не нужна и каждый элемент переносится один раз
+inline void mergeDescending(std::vector<IpAddress>& base,
+   std::span<const IpAddress> delta) {
+   std::size_t left{base.size()};
+   std::size_t right{delta.size()};
+   base.resize(left + right);
+   for (std::size_t out{base.size()}; right != 0;) {
+      // С конца идут наименьшие адреса
+      if (left != 0 && base[left - 1] < delta[right - 1]) {
+         base[--out] = base[--left];
+      }
+      else {
+         base[--out] = delta[--right];
+      }
+   }
+}
+
+} // namespace detail
+
+// Формат файла пула: заголовок IncrementalHeader, за ним poolSize адресов
+// пула и anyByteSize адресов списка, по 4 байта в порядке байтов машины.
+// Порядок байтов и контрольные суммы -- как у снимка (ip_snapshot.hpp)
+inline constexpr std::array<char, 8> incrementalMagic{'I', 'P', 'B', 'A', 'S', 'E', 0, 0};
+inline constexpr std::uint32_t incrementalVersion{1};
+
+struct IncrementalHeader {
+   std::array<char, 8> magic;     // incrementalMagic
+   std::uint32_t version;         // incrementalVersion
+   std::uint32_t byteOrder;       // snapshotByteOrder
+   std::uint64_t poolSize;        // Число адресов пула
+   std::uint64_t anyByteSize;     // Число адресов списка
+   std::uint64_t dataChecksum;    // Контрольная сумма пула и списка
+   std::uint64_t headerChecksum;  // Контрольная сумма полей выше
+};
+
+static_assert(std::is_trivially_copyable_v<IncrementalHeader>);
+
+// Пул, пополняемый порциями новых адресов.
+// Пул хранится отсортированным, вместе с ним хранится отсортированный
+// список адресов с любым октетом 46. Новая порция сортируется отдельно и
+// сливается с пулом и со списком за линейное время. Списки filter(1) и
+// filter(46, 70) -- непрерывные части пула и находятся двоичным поиском.
+// Состояние сохраняется в файл и загружается при следующем запуске
+class IncrementalPool {
+private:
+   // Фильтр четвёртого раздела вывода
+   static constexpr AnyByteFilter anyByteFilter{filter_any(46)};
+
+   std::vector<IpAddress> m_pool;    // Весь пул по убыванию
+   std::vector<IpAddress> m_anyByte; // Адреса с любым октетом 46 по убыванию
+
+   [[noreturn]] static void fail(const std::string& what) {
+      throw std::system_error{errno, std::generic_category(), what};
+   }
+
+   // Контрольная сумма пула и списка
+   static std::uint64_t checksum(std::span<const IpAddress> pool,
+      std::span<const IpAddress> anyByte) noexcept {
+      return snapshotChecksum(pool) ^ (snapshotChecksum(anyByte) * 31);
+   }
+public:
+   // Пустой пул
+   IncrementalPool() = default;
+
+   // Дополнение пула новыми адресами в любом порядке.
+   // Сортируется только порция, пул и список сливаются с её частями
+   void append(std::vector<IpAddress> delta,
+      SortEngine engine = SortEngine::radix, unsigned threads = 1) {
+      sortIP(delta, engine, threads);
+      std::vector<IpAddress> anyByte{};
+      std::ranges::copy_if(delta, std::back_inserter(anyByte), anyByteFilter);
+      detail::mergeDescending(m_pool, delta);
+      detail::mergeDescending(m_anyByte, anyByte);
+   }
+
+   // Весь пул
+   std::span<const IpAddress> pool() const noexcept {
+      return m_pool;
+   }
+
+   // Адреса, прошедшие фильтр filter(...) по первым октетам.
+   // Маскированные адреса тоже идут по убыванию, поэтому подходящие
+   // адреса находятся двоичным поиском
+   template<std::size_t N>
+   std::span<const IpAddress> find(PrefixFilter<N> prefix) const {
+      auto found = std::ranges::equal_range(m_pool, prefix.prefix().value(),
+         std::greater<>{}, [](IpAddress ip) {
+            return ip.value() & PrefixFilter<N>::mask;
+         });
+      return {found.begin(), found.end()};
+   }
+
+   // Адреса с любым октетом 46
+   std::span<const IpAddress> anyByte() const noexcept {
+      return m_anyByte;
+   }
+
+   // Сохранение состояния: заголовок с размерами и контрольными суммами,
+   // затем сами адреса. Запись идёт во временный файл, который затем
+   // заменяет прежний, поэтому сбой посреди записи не портит сохранённый пул
+   void save(const std::string& path) const {
+      IncrementalHeader header{};
+      header.magic = incrementalMagic;
+      header.version = incrementalVersion;
+      header.byteOrder = snapshotByteOrder;
+      header.poolSize = m_pool.size();
+      header.anyByteSize = m_anyByte.size();
+      header.dataChecksum = checksum(m_pool, m_anyByte);
+      header.headerChecksum = fnv1a(&header,
+         offsetof(IncrementalHeader, headerChecksum));
+
+      const std::string temporary{path + ".tmp"};
+      FileHandle file{std::fopen(temporary.c_str(), "wb")};
+      if (!file) fail(temporary);
+      if (std::fwrite(&header, sizeof(header), 1, file.get()) != 1
+         || std::fwrite(m_pool.data(), sizeof(IpAddress), m_pool.size(),
+            file.get()) != m_pool.size()
+         || std::fwrite(m_anyByte.data(), sizeof(IpAddress), m_anyByte.size(),
+            file.get()) != m_anyByte.size()
+         || std::fclose(file.release()) != 0) {
+         fail(temporary);
+      }
+      if (std::rename(temporary.c_str(), path.c_str()) != 0) fail(path);
+   }
+
+   // Загрузка состояния. Отсутствующий файл -- пустой пул первого запуска.
+   // Размеры из заголовка сверяются с размером файла до выделения памяти,
+   // поэтому чужой или повреждённый файл не приводит к огромному resize
+   static IncrementalPool load(const std::string& path) {
+      IncrementalPool result{};
+      FileHandle file{std::fopen(path.c_str(), "rb")};
+      if (!file) {
+         if (errno == ENOENT) return result;
+         fail(path);
+      }
+      auto corrupted = [&path](const char* what) {
+         throw std::runtime_error{path + ": " + what};
+      };
+      if (std::fseek(file.get(), 0, SEEK_END) != 0) fail(path);
+      long fileSize{std::ftell(file.get())};
+      if (fileSize < 0) fail(path);
+      std::rewind(file.get());
+
+      IncrementalHeader header{};
+      if (std::fread(&header, sizeof(header), 1, file.get()) != 1
+         || header.magic != incrementalMagic) {
+         corrupted("не является файлом пула");
+      }
+      if (header.byteOrder != snapshotByteOrder) corrupted("другой порядок байтов");
+      if (header.version != incrementalVersion) {
+         corrupted("неподдерживаемая версия файла пула");
+      }
+      if (header.headerChecksum != fnv1a(&header,
+            offsetof(IncrementalHeader, headerChecksum))) {
+         corrupted("повреждён заголовок файла пула");
+      }
+      const std::uint64_t dataSize{
+         static_cast<std::uint64_t>(fileSize) - sizeof(header)};
+      if (header.anyByteSize > header.poolSize
+         || dataSize % sizeof(IpAddress) != 0
+         || dataSize / sizeof(IpAddress) != header.poolSize + header.anyByteSize) {
+         corrupted("размер файла не совпадает с заголовком");
+      }
+      result.m_pool.resize(static_cast<std::size_t>(header.poolSize));
+      result.m_anyByte.resize(static_cast<std::size_t>(header.anyByteSize));
+      if (std::fread(result.m_pool.data(), sizeof(IpAddress),
+            result.m_pool.size(), file.get()) != result.m_pool.size()
+         || std::fread(result.m_anyByte.data(), sizeof(IpAddress),
+            result.m_anyByte.size(), file.get()) != result.m_anyByte.size()
+         || checksum(result.m_pool, result.m_anyByte) != header.dataChecksum) {
+         corrupted("повреждены адреса файла пула");
+      }
+      return result;
+   }
+};
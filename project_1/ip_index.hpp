@@ -0,0 +1,134 @@
+// ip_index.hpp -- индекс префиксов над отсортированным пулом ip-адресов
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include "ip_address.hpp"
+#include "ip_filters.hpp"
+#include "ip_parser.hpp"
+
+// Сеть в CIDR-записи, например 46.70.0.0/16
+struct CidrBlock {
+   IpAddress network{};  // Адрес сети
+   unsigned length{};    // Длина префикса в битах [0-32]
+
+   // Маска префикса
+   constexpr std::uint32_t mask() const noexcept {
+      return length == 0 ? 0u : ~std::uint32_t{} << (32 - length);
+   }
+
+   // Наименьший адрес сети
+   constexpr IpAddress first() const noexcept {
+      return IpAddress{network.value() & mask()};
+   }
+
+   // Наибольший адрес сети
+   constexpr IpAddress last() const noexcept {
+      return IpAddress{network.value() | ~mask()};
+   }
+};
+
+// Разбор CIDR-записи n1.n2.n3.n4/len
+inline std::optional<CidrBlock> parseCidr(std::string_view text) noexcept {
+   std::size_t slash{text.find('/')};
+   if (slash == std::string_view::npos) return std::nullopt;
+   auto network = parseIP(text.substr(0, slash));
+   std::string_view digits{text.substr(slash + 1)};
+   if (!network || digits.empty() || digits.size() > 2) return std::nullopt;
+   unsigned length{};
+   for (char ch : digits) {
+      if (ch < '0' || ch > '9') return std::nullopt;
+      length = length * 10 + static_cast<unsigned>(ch - '0');
+   }
+   if (length > 32) return std::nullopt;
+   return CidrBlock{*network, length};
+}
+
+// Индекс над пулом, отсортированным в обратном лексикографическом порядке.
+// В таком пуле адреса с общим префиксом и любой диапазон адресов лежат
+// подряд, поэтому результат запроса -- часть пула без копирования.
+// Таблица из 257 смещений сразу даёт границы по первому октету,
+// более длинные префиксы ищутся двоичным поиском внутри этих границ
+class PrefixIndex {
+private:
+   std::span<const IpAddress> m_pool;     // Отсортированный пул
+   std::array<std::size_t, 257> m_offsets; // Начало адресов с октетом 255-i
+public:
+   // Индекс строится один раз за проход по пулу
+   explicit PrefixIndex(std::span<const IpAddress> sortedPool) noexcept
+      : m_pool{sortedPool}, m_offsets{} {
+         std::array<std::size_t, 256> counts{};
+         for (IpAddress ip : m_pool) {
+            ++counts[ip.octet(0)];
+         }
+         // Пул идёт по убыванию, поэтому первыми лежат адреса с октетом 255
+         for (std::size_t i{}; i < 256; ++i) {
+            m_offsets[i + 1] = m_offsets[i] + counts[255 - i];
+         }
+   }
+
+   // Индекс с готовой таблицей смещений, например из снимка пула.
+   // Смещения не пересчитываются, пул не просматривается
+   PrefixIndex(std::span<const IpAddress> sortedPool,
+      const std::array<std::size_t, 257>& offsets) noexcept
+      : m_pool{sortedPool}, m_offsets{offsets} {}
+
+   // Весь пул
+   std::span<const IpAddress> pool() const noexcept {
+      return m_pool;
+   }
+
+   // Таблица смещений: адреса с первым октетом 255-i лежат в пуле
+   // с позиции offsets()[i] до offsets()[i + 1]
+   const std::array<std::size_t, 257>& offsets() const noexcept {
+      return m_offsets;
+   }
+
+   // Адреса с первым октетом first -- за O(1)
+   std::span<const IpAddress> firstOctet(std::uint8_t first) const noexcept {
+      std::size_t slot{255u - first};
+      return m_pool.subspan(m_offsets[slot],
+         m_offsets[slot + 1] - m_offsets[slot]);
+   }
+
+   // Адреса из диапазона [low, high] включительно
+   std::span<const IpAddress> range(IpAddress low, IpAddress high) const {
+      if (high < low) return {};
+      // Ограничиваем поиск первыми октетами границ
+      std::size_t begin{m_offsets[255u - high.octet(0)]};
+      std::size_t end{m_offsets[256u - low.octet(0)]};
+      auto part = m_pool.subspan(begin, end - begin);
+      // Пул упорядочен по убыванию
+      auto from = std::lower_bound(part.begin(), part.end(), high,
+         std::greater<IpAddress>{});
+      auto to = std::upper_bound(from, part.end(), low,
+         std::greater<IpAddress>{});
+      return {from, to};
+   }
+
+   // Адреса, прошедшие фильтр filter(...) по первым октетам
+   template<std::size_t N>
+   std::span<const IpAddress> find(PrefixFilter<N> prefix) const {
+      if constexpr (N == 1) {
+         return firstOctet(prefix.prefix().octet(0));
+      }
+      else {
+         std::uint32_t low{prefix.prefix().value()};
+         return range(IpAddress{low},
+            IpAddress{low | ~PrefixFilter<N>::mask});
+      }
+   }
+
+   // Адреса из сети, например 46.70.0.0/16
+   std::span<const IpAddress> find(const CidrBlock& block) const {
+      return range(block.first(), block.last());
+   }
+};
@@ -0,0 +1,157 @@
+// ip_output.hpp -- буферизованный вывод ip-адресов
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <unistd.h>
+
+#include "ip_address.hpp"
+
+// Текстовое представление октета: до трёх цифр и их количество
+struct OctetText {
+   std::array<char, 3> digits;
+   std::uint8_t length;
+};
+
+// Таблица текстов всех 256 значений октета, строится при компиляции
+inline constexpr std::array<OctetText, 256> octetTable = [] {
+   std::array<OctetText, 256> table{};
+   for (unsigned value{}; value < 256; ++value) {
+      OctetText& text = table[value];
+      if (value >= 100) {
+         text.digits = {static_cast<char>('0' + value / 100),
+            static_cast<char>('0' + value / 10 % 10),
+            static_cast<char>('0' + value % 10)};
+         text.length = 3;
+      }
+      else if (value >= 10) {
+         text.digits = {static_cast<char>('0' + value / 10),
+            static_cast<char>('0' + value % 10), '\0'};
+         text.length = 2;
+      }
+      else {
+         text.digits = {static_cast<char>('0' + value), '\0', '\0'};
+         text.length = 1;
+      }
+   }
+   return table;
+}();
+
+// Наибольшая длина адреса с переводом строки: "255.255.255.255\n"
+inline constexpr std::size_t maxLineLength{16};
+
+// Записывает адрес и перевод строки в out, возвращает число байт.
+// В out должно быть не меньше maxLineLength байт
+inline std::size_t formatIP(IpAddress ip, char* out) noexcept {
+   char* current{out};
+   for (std::size_t i{}; i < 4; ++i) {
+      const OctetText& text = octetTable[ip.octet(i)];
+      // Копируем все три байта, лишние перезапишет следующий символ
+      std::memcpy(current, text.digits.data(), 3);
+      current += text.length;
+      *current++ = i == 3 ? '\n' : '.';
+   }
+   return static_cast<std::size_t>(current - out);
+}
+
+// Вывод адресов в файловый дескриптор через большой буфер.
+// Адреса форматируются прямо в буфер, буфер сбрасывается редкими
+// крупными вызовами write
+class IpWriter {
+private:
+   int m_fd;                  // Дескриптор вывода
+   std::vector<char> m_buffer; // Буфер вывода
+   std::size_t m_used;         // Занято байт в буфере
+   std::size_t m_written;      // Всего записано байт
+public:
+   // Конструктор по умолчанию пишет в стандартный вывод
+   explicit IpWriter(int fd = STDOUT_FILENO,
+      std::size_t capacity = std::size_t{1} << 20)
+      : m_fd{fd}, m_buffer(std::max(capacity, maxLineLength)), m_used{},
+      m_written{} {}
+
+   // Деструктор дописывает остаток буфера
+   ~IpWriter() {
+      try {
+         flush();
+      }
+      catch (...) {
+         // Ошибку записи из деструктора сообщить некуда
+      }
+   }
+
+   // Копирующий конструктор запрещён
+   IpWriter(const IpWriter&) = delete;
+
+   // Конструктор копирующего присваивания запрещён
+   IpWriter& operator=(const IpWriter&) = delete;
+
+   // Вывод одного адреса в отдельной строке
+   void write(IpAddress ip) {
+      if (m_buffer.size() - m_used < maxLineLength) flush();
+      m_used += formatIP(ip, m_buffer.data() + m_used);
+   }
+
+   // Вывод списка адресов, один адрес в строке
+   void write(std::span<const IpAddress> addresses) {
+      for (IpAddress ip : addresses) {
+         write(ip);
+      }
+   }
+
+   // Вывод произвольного текста
+   void write(std::string_view text) {
+      while (!text.empty()) {
+         if (m_used == m_buffer.size()) flush();
+         std::size_t part{std::min(text.size(), m_buffer.size() - m_used)};
+         std::memcpy(m_buffer.data() + m_used, text.data(), part);
+         m_used += part;
+         text.remove_prefix(part);
+      }
+   }
+
+   // Запись содержимого буфера в дескриптор
+   void flush() {
+      const char* data{m_buffer.data()};
+      std::size_t left{m_used};
+      while (left != 0) {
+         ssize_t written{::write(m_fd, data, left)};
+         if (written < 0) {
+            if (errno == EINTR) continue;
+            int error = errno;
+            m_used = 0;
+            throw std::system_error{error, std::generic_category(), "write"};
+         }
+         data += written;
+         left -= static_cast<std::size_t>(written);
+      }
+      m_written += m_used;
+      m_used = 0;
+   }
+
+   // Всего записано байт, включая ещё не сброшенные
+   std::size_t bytesWritten() const noexcept {
+      return m_written + m_used;
+   }
+};
+
+// Добавляет адреса в строку, один адрес в строке
+inline void appendIP(std::span<const IpAddress> addresses, std::string& out) {
+   std::size_t size{out.size()};
+   out.resize(size + addresses.size() * maxLineLength);
+   for (IpAddress ip : addresses) {
+      size += formatIP(ip, out.data() + size);
+   }
+   out.resize(size);
+}
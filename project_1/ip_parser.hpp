@@ -0,0 +1,149 @@
+// ip_parser.hpp -- разбор текстовой записи IPv4-адреса
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+
+#include "ip_address.hpp"
+
+// Правила разбора те же, что у invalidIP: ровно 4 октета через точку,
+// в каждом только цифры, значение в диапазоне [0-255], ведущие нули
+// допустимы. Для некорректного адреса возвращается std::nullopt
+
+// Побайтовый разбор, подходит для строки любой длины
+inline std::optional<IpAddress> parseIPScalar(std::string_view text) noexcept {
+   std::uint32_t packed{};
+   std::size_t pos{};
+   for (int i{}; i < 4; ++i) {
+      // Октеты, кроме первого, отделяются точкой
+      if (i != 0) {
+         if (pos == text.size() || text[pos] != '.') return std::nullopt;
+         ++pos;
+      }
+      std::size_t start{pos};
+      std::uint32_t octet{};
+      while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+         octet = octet * 10 + static_cast<std::uint32_t>(text[pos] - '0');
+         // Ведущие нули допустимы, поэтому проверяем значение, а не длину
+         if (octet > 255) return std::nullopt;
+         ++pos;
+      }
+      if (pos == start) return std::nullopt;
+      packed = (packed << 8) | octet;
+   }
+   if (pos != text.size()) return std::nullopt;
+   return IpAddress{packed};
+}
+
+namespace detail {
+
+inline constexpr std::uint64_t ones{0x0101010101010101ull};
+inline constexpr std::uint64_t highs{0x8080808080808080ull};
+
+// Старший бит каждого байта, равного byte (точная проверка без переносов)
+constexpr std::uint64_t equalBytes(std::uint64_t word, std::uint8_t byte) noexcept {
+   std::uint64_t x{word ^ (ones * byte)};
+   return ~(((x & ~highs) + ~highs) | x) & highs;
+}
+
+// Старший бит каждого байта, который не является цифрой '0'-'9'
+constexpr std::uint64_t nonDigitBytes(std::uint64_t word) noexcept {
+   // Байт меньше '0' даёт заём при вычитании, байт больше '9' --
+   // перенос при сложении с 0x46; байты с установленным старшим битом
+   // отбрасываются сразу
+   std::uint64_t low{(word | highs) - ones * '0'};
+   std::uint64_t high{(word & ~highs) + ones * (0x80 - ':')};
+   return (~low | high | word) & highs;
+}
+
+// Сжатие старших битов восьми байтов в 8-битную маску
+constexpr unsigned byteMask(std::uint64_t bits) noexcept {
+   return static_cast<unsigned>(((bits >> 7) * 0x0102040810204080ull) >> 56);
+}
+
+} // namespace detail
+
+// SWAR-разбор: строка длиной 7-15 байт обрабатывается как два 64-битных
+// слова. Точки и недопустимые символы находятся масками для всех байтов
+// сразу, границы октетов -- по битам маски точек, значения октетов --
+// без циклов по символам. Более длинные строки (ведущие нули) и редкие
+// случаи октетов длиннее трёх цифр разбираются побайтово
+inline std::optional<IpAddress> parseIP(std::string_view text) noexcept {
+   const std::size_t length{text.size()};
+   // Маски ниже рассчитаны на порядок байтов little-endian
+   if constexpr (std::endian::native != std::endian::little) {
+      return parseIPScalar(text);
+   }
+   if (length < 7 || length > 15) return parseIPScalar(text);
+
+   // Загрузка строки в два слова перекрывающимися чтениями фиксированной
+   // длины, байты за концом строки -- нули
+   const char* data{text.data()};
+   std::uint64_t lo{};
+   std::uint64_t hi{};
+   if (length >= 8) {
+      std::memcpy(&lo, data, 8);
+      std::memcpy(&hi, data + length - 8, 8);
+      hi = length == 8 ? 0 : hi >> (8 * (16 - length));
+   }
+   else {
+      std::uint32_t head{};
+      std::uint32_t tail{};
+      std::memcpy(&head, data, 4);
+      std::memcpy(&tail, data + length - 4, 4);
+      lo = head | (std::uint64_t{tail} << (8 * (length - 4)));
+   }
+
+   // Маски по одному биту на байт строки
+   const unsigned used{(1u << length) - 1};
+   const unsigned dots{(detail::byteMask(detail::equalBytes(lo, '.'))
+      | (detail::byteMask(detail::equalBytes(hi, '.')) << 8)) & used};
+   const unsigned others{(detail::byteMask(detail::nonDigitBytes(lo))
+      | (detail::byteMask(detail::nonDigitBytes(hi)) << 8)) & used};
+   // Кроме цифр допустимы только три точки. Число точек проверяем
+   // сбросом младших битов: std::popcount без -mpopcnt -- вызов функции
+   const unsigned rest{dots & (dots - 1)};
+   const unsigned last{rest & (rest - 1)};
+   if (others != dots || last == 0 || (last & (last - 1)) != 0) {
+      return std::nullopt;
+   }
+
+   // Границы октетов: позиции точек и конец строки
+   const unsigned dot1{static_cast<unsigned>(std::countr_zero(dots))};
+   const unsigned dot2{static_cast<unsigned>(std::countr_zero(rest))};
+   const unsigned dot3{static_cast<unsigned>(std::countr_zero(last))};
+   const unsigned ends[4]{dot1, dot2, dot3, static_cast<unsigned>(length)};
+   const unsigned starts[4]{0, dot1 + 1, dot2 + 1, dot3 + 1};
+
+   // Слова строки с двумя нулевыми байтами впереди: три байта,
+   // заканчивающиеся любой позицией строки, читаются одной загрузкой
+   unsigned char bytes[20]{};
+   std::memcpy(bytes + 2, &lo, 8);
+   std::memcpy(bytes + 10, &hi, 8);
+
+   std::uint32_t packed{};
+   for (int i{}; i < 4; ++i) {
+      const unsigned size{ends[i] - starts[i]};
+      // Пустой октет -- две точки подряд или точка на краю строки
+      if (size == 0) return std::nullopt;
+      if (size > 3) return parseIPScalar(text);
+      // Три байта, заканчивающиеся последней цифрой октета:
+      // младший байт -- сотни, старший -- единицы
+      const unsigned end{ends[i] - 1};
+      std::uint32_t window{};
+      std::memcpy(&window, bytes + end, 4);
+      // Оставляем только цифры октета, недостающие старшие цифры -- 0
+      const std::uint32_t mask{0xFFFFFFu << (8 * (3 - size)) & 0xFFFFFFu};
+      const std::uint32_t digits{(window & mask) - (0x303030u & mask)};
+      const std::uint32_t octet{(digits & 0xFF) * 100
+         + ((digits >> 8) & 0xFF) * 10 + (digits >> 16)};
+      if (octet > 255) return std::nullopt;
+      packed = (packed << 8) | octet;
+   }
+   return IpAddress{packed};
+}
@@ -0,0 +1,272 @@
+// ip_reader.hpp -- загрузка ip-адресов из отображённого в память файла
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ip_address.hpp"
+#include "ip_parser.hpp"
+#include "ip_stats.hpp"
+
+// Обычный ли файл path. Канал, FIFO и подстановка процесса <(...)
+// размера не имеют, отобразить их в память нельзя
+inline bool isRegularFile(const std::string& path) noexcept {
+   struct stat info{};
+   return ::stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+}
+
+// Файл, отображённый в память только для чтения.
+// Память освобождается в деструкторе. Отображается только обычный файл
+class MappedFile {
+private:
+   const char* m_data;  // Начало отображения
+   std::size_t m_size;  // Размер файла в байтах
+public:
+   // Конструктор открывает и отображает файл целиком.
+   // advice -- ожидаемый порядок доступа для madvise
+   explicit MappedFile(const std::string& path, int advice = MADV_SEQUENTIAL)
+      : m_data{nullptr}, m_size{} {
+         // O_NONBLOCK: открытие FIFO без писателя не ждёт, а сразу
+         // доходит до проверки типа файла
+         int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+         if (fd == -1) {
+            throw std::system_error{errno, std::generic_category(), path};
+         }
+         struct stat info{};
+         if (::fstat(fd, &info) == -1) {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error{error, std::generic_category(), path};
+         }
+         // У канала st_size равен нулю, и он читался бы как пустой файл
+         if (!S_ISREG(info.st_mode)) {
+            ::close(fd);
+            throw std::system_error{std::make_error_code(std::errc::invalid_argument),
+               path + ": не является обычным файлом"};
+         }
+         m_size = static_cast<std::size_t>(info.st_size);
+         // Пустой файл отобразить нельзя, он просто не содержит строк
+         if (m_size != 0) {
+            void* addr = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE,
+               fd, 0);
+            if (addr == MAP_FAILED) {
+               int error = errno;
+               ::close(fd);
+               throw std::system_error{error, std::generic_category(), path};
+            }
+            ::madvise(addr, m_size, advice);
+            m_data = static_cast<const char*>(addr);
+         }
+         // Отображение остаётся действительным после закрытия дескриптора
+         ::close(fd);
+   }
+
+   // Деструктор
+   ~MappedFile() {
+      if (m_data) {
+         ::munmap(const_cast<char*>(m_data), m_size);
+      }
+   }
+
+   // Копирующий конструктор запрещён
+   MappedFile(const MappedFile&) = delete;
+
+   // Конструктор копирующего присваивания запрещён
+   MappedFile& operator=(const MappedFile&) = delete;
+
+   // Содержимое файла
+   std::string_view data() const noexcept {
+      return {m_data, m_size};
+   }
+};
+
+// Закрытие файла std::FILE в деструкторе std::unique_ptr
+struct FileCloser {
+   void operator()(std::FILE* file) const noexcept {
+      std::fclose(file);
+   }
+};
+
+// Владеющий указатель на открытый файл std::FILE
+using FileHandle = std::unique_ptr<std::FILE, FileCloser>;
+
+// Первое поле строки -- всё до табуляции, пробела или конца строки.
+// Пробельные символы в начале строки пропускаются, как при std::cin >> line
+inline std::string_view firstField(std::string_view line) noexcept {
+   std::size_t start{line.find_first_not_of("\t \r")};
+   if (start == std::string_view::npos) return {};
+   line.remove_prefix(start);
+   std::size_t stop{line.find_first_of("\t \r")};
+   return stop == std::string_view::npos ? line : line.substr(0, stop);
+}
+
+// Учёт прочитанной строки line (без '\n') в input. parsed -- адрес
+// строки разобран; пустая строка или строка из пробелов не отброшена
+inline void countLine(InputStats& input, std::string_view line,
+   bool parsed) noexcept {
+   ++input.lines;
+   input.bytes += line.size() + 1;
+   if (!parsed && !firstField(line).empty()) ++input.rejected;
+}
+
+// Разбирает буфер построчно на месте и добавляет корректные адреса в пул.
+// Строки с некорректным адресом пропускаются
+inline void parseBuffer(std::string_view buffer, std::vector<IpAddress>& ipPool) {
+   const char* current{buffer.data()};
+   const char* end{buffer.data() + buffer.size()};
+   while (current < end) {
+      const char* eol = static_cast<const char*>(
+         std::memchr(current, '\n', static_cast<std::size_t>(end - current)));
+      if (!eol) eol = end;
+      std::string_view line{current, static_cast<std::size_t>(eol - current)};
+      if (auto ip = parseIP(firstField(line))) {
+         ipPool.push_back(*ip);
+      }
+      current = eol + 1;
+   }
+}
+
+// Делит буфер на части примерно равного размера по границам строк.
+// Каждая часть, кроме, возможно, последней, заканчивается символом '\n'
+inline std::vector<std::string_view> splitChunks(std::string_view buffer,
+   std::size_t count) {
+   std::vector<std::string_view> chunks{};
+   if (count == 0) count = 1;
+   chunks.reserve(count);
+   std::size_t start{};
+   for (std::size_t i{1}; i <= count && start < buffer.size(); ++i) {
+      std::size_t stop{buffer.size()};
+      if (i != count) {
+         // Сдвигаем границу к концу ближайшей строки
+         std::size_t eol{buffer.find('\n', std::max(start, buffer.size() * i / count))};
+         stop = eol == std::string_view::npos ? buffer.size() : eol + 1;
+      }
+      chunks.push_back(buffer.substr(start, stop - start));
+      start = stop;
+   }
+   return chunks;
+}
+
+// Параллельный разбор буфера: каждая часть разбирается в своём потоке,
+// затем результаты склеиваются в исходном порядке строк.
+// Результат побайтово совпадает с последовательным parseBuffer
+inline std::vector<IpAddress> parseBufferParallel(std::string_view buffer,
+   unsigned threads) {
+   std::vector<IpAddress> ipPool{};
+   auto chunks = splitChunks(buffer, threads);
+   if (chunks.size() <= 1) {
+      ipPool.reserve(buffer.size() / 8 + 1);
+      parseBuffer(buffer, ipPool);
+      return ipPool;
+   }
+
+   // Разбор частей
+   std::vector<std::vector<IpAddress>> parts(chunks.size());
+   {
+      std::vector<std::jthread> workers{};
+      workers.reserve(chunks.size());
+      for (std::size_t i{}; i < chunks.size(); ++i) {
+         workers.emplace_back([&parts, &chunks, i] {
+            parts[i].reserve(chunks[i].size() / 8 + 1);
+            parseBuffer(chunks[i], parts[i]);
+         });
+      }
+   }
+
+   // Склейка частей: смещение каждой части известно заранее,
+   // поэтому копирование тоже выполняется параллельно
+   std::vector<std::size_t> offsets(parts.size() + 1);
+   for (std::size_t i{}; i < parts.size(); ++i) {
+      offsets[i + 1] = offsets[i] + parts[i].size();
+   }
+   ipPool.resize(offsets.back());
+   {
+      std::vector<std::jthread> workers{};
+      workers.reserve(parts.size());
+      for (std::size_t i{}; i < parts.size(); ++i) {
+         workers.emplace_back([&ipPool, &parts, &offsets, i] {
+            std::ranges::copy(parts[i], ipPool.begin()
+               + static_cast<std::ptrdiff_t>(offsets[i]));
+            std::vector<IpAddress>{}.swap(parts[i]);
+         });
+      }
+   }
+   return ipPool;
+}
+
+// Число строк в буфере, включая последнюю строку без '\n'
+inline std::size_t countLines(std::string_view buffer) noexcept {
+   std::size_t lines{static_cast<std::size_t>(
+      std::ranges::count(buffer, '\n'))};
+   return lines + (!buffer.empty() && buffer.back() != '\n' ? 1 : 0);
+}
+
+// Число пустых строк и строк из одних пробелов в буфере
+inline std::size_t countBlankLines(std::string_view buffer) noexcept {
+   std::size_t blank{};
+   while (!buffer.empty()) {
+      std::size_t eol{std::min(buffer.find('\n'), buffer.size())};
+      if (firstField(buffer.substr(0, eol)).empty()) ++blank;
+      buffer.remove_prefix(std::min(eol + 1, buffer.size()));
+   }
+   return blank;
+}
+
+// Наибольшее число потоков на одно ядро для --threads
+inline constexpr unsigned maxThreadsPerCore{8};
+
+// Разбор числа потоков --threads: целое от 1 до maxThreadsPerCore потоков
+// на ядро. std::stoul принимает знак минус и мусор после числа, поэтому
+// строка проверяется целиком
+inline unsigned parseThreadCount(const std::string& text) {
+   unsigned count{};
+   auto [end, error] = std::from_chars(text.data(), text.data() + text.size(),
+      count);
+   if ((error != std::errc{} && error != std::errc::result_out_of_range)
+      || end != text.data() + text.size() || (error == std::errc{} && count == 0)) {
+      throw std::invalid_argument{"неверное число потоков " + text};
+   }
+   const unsigned limit{maxThreadsPerCore
+      * std::max(1u, std::thread::hardware_concurrency())};
+   if (error == std::errc::result_out_of_range || count > limit) {
+      throw std::out_of_range{"слишком много потоков " + text
+         + ", не больше " + std::to_string(limit)};
+   }
+   return count;
+}
+
+// Загрузка ip-адресов из файла через отображение в память.
+// threads -- число потоков разбора, 1 -- последовательный разбор.
+// input -- если задан, в него добавляются объём, число строк файла и
+// число отброшенных строк: каждая непустая строка даёт не больше одного
+// адреса, поэтому разбор не приходится замедлять счётчиком
+inline std::vector<IpAddress> loadFile(const std::string& path,
+   unsigned threads = 1, InputStats* input = nullptr) {
+   MappedFile file{path};
+   std::vector<IpAddress> ipPool{parseBufferParallel(file.data(), threads)};
+   if (input) {
+      const std::size_t lines{countLines(file.data())};
+      input->bytes += file.data().size();
+      input->lines += lines;
+      input->rejected += lines - countBlankLines(file.data()) - ipPool.size();
+   }
+   return ipPool;
+}
@@ -0,0 +1,280 @@
+// ip_server.hpp -- режим ответа на запросы к загруженному пулу ip-адресов
+
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "ip_address.hpp"
+#include "ip_filters.hpp"
+#include "ip_index.hpp"
+#include "ip_output.hpp"
+#include "ip_simd.hpp"
+
+// Сервер запросов: пул загружается, сортируется и индексируется один раз,
+// после чего на каждый запрос отвечает индекс без повторного разбора.
+// Запросы по одному в строке:
+//    prefix 46.70                  -- адреса с первыми октетами 46.70
+//    any 46                        -- адреса, любой октет которых равен 46
+//    cidr 46.70.0.0/16             -- адреса из сети
+//    range 1.0.0.0 1.255.255.255   -- адреса из диапазона включительно
+//    shutdown                      -- остановить сервер (режим сокета)
+// Ответ -- найденные адреса по одному в строке и строка состояния
+//    OK count=<число адресов> time_us=<время ответа в микросекундах>
+// либо одна строка ERR <описание ошибки> time_us=<время ответа>
+class QueryServer {
+public:
+   // Наибольшая длина запроса. Клиент, приславший больше без перевода
+   // строки, отключается: клиенты обслуживаются по очереди, и один такой
+   // клиент иначе занимал бы сервер и память без ограничения
+   static constexpr std::size_t maxQueryLength{4096};
+private:
+   using Clock = std::chrono::steady_clock;
+
+   std::span<const IpAddress> m_pool; // Отсортированный пул
+   PrefixIndex m_index;               // Индекс по пулу
+   bool m_stopped;                    // Получена команда shutdown
+
+   // Разбор префикса из 1-4 октетов: "46", "46.70", "46.70.1"
+   static std::optional<CidrBlock> parsePrefix(std::string_view text) {
+      std::string full{text};
+      unsigned octets{1};
+      for (char ch : text) {
+         if (ch == '.') ++octets;
+      }
+      if (octets > 4) return std::nullopt;
+      for (unsigned i{octets}; i < 4; ++i) {
+         full += ".0";
+      }
+      auto network = parseIP(full);
+      if (!network) return std::nullopt;
+      return CidrBlock{*network, octets * 8};
+   }
+
+   // Разбор значения октета [0-255]
+   static std::optional<std::uint8_t> parseByte(std::string_view text) {
+      if (text.empty() || text.size() > 3) return std::nullopt;
+      unsigned value{};
+      for (char ch : text) {
+         if (ch < '0' || ch > '9') return std::nullopt;
+         value = value * 10 + static_cast<unsigned>(ch - '0');
+      }
+      if (value > 255) return std::nullopt;
+      return static_cast<std::uint8_t>(value);
+   }
+
+   // Формирует ответ без строки состояния, возвращает число адресов
+   // или сообщение об ошибке
+   std::size_t execute(std::string_view command, std::string_view argument,
+      std::string& response, std::string& error) {
+      if (command == "prefix") {
+         if (auto block = parsePrefix(argument)) {
+            auto found = m_index.find(*block);
+            appendIP(found, response);
+            return found.size();
+         }
+         error = "неверный префикс";
+      }
+      else if (command == "cidr") {
+         if (auto block = parseCidr(argument)) {
+            auto found = m_index.find(*block);
+            appendIP(found, response);
+            return found.size();
+         }
+         error = "неверная запись CIDR";
+      }
+      else if (command == "range") {
+         std::size_t space{argument.find(' ')};
+         auto low = parseIP(argument.substr(0, space));
+         auto high = space == std::string_view::npos ? std::nullopt
+            : parseIP(argument.substr(space + 1));
+         if (low && high) {
+            auto found = m_index.range(*low, *high);
+            appendIP(found, response);
+            return found.size();
+         }
+         error = "неверный диапазон";
+      }
+      else if (command == "any") {
+         auto byte = parseByte(argument);
+         if (byte) {
+            IndexList found{filterAnyByte(m_pool, filter_any(*byte))};
+            char line[maxLineLength];
+            for (std::size_t index : found) {
+               response.append(line, formatIP(m_pool[index], line));
+            }
+            return found.size();
+         }
+         error = "неверное значение октета";
+      }
+      else {
+         error = "неизвестный запрос";
+      }
+      return 0;
+   }
+
+   // Строка состояния ответа: status и время от start
+   static void finish(std::string& response, std::string_view status,
+      Clock::time_point start) {
+      auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+         Clock::now() - start);
+      response += status;
+      response += " time_us=" + std::to_string(elapsed.count()) + '\n';
+   }
+
+   // Отказ клиенту, приславшему слишком длинный запрос
+   static void rejectLong(int client, Clock::time_point start) {
+      std::string response{};
+      finish(response, "ERR слишком длинный запрос", start);
+      sendAll(client, response);
+   }
+
+   // Чтение запросов из сокета клиента до закрытия соединения
+   void serveClient(int client) {
+      std::string pending{};
+      std::string response{};
+      char buffer[4096];
+      while (!m_stopped) {
+         ssize_t received{::recv(client, buffer, sizeof(buffer), 0)};
+         if (received < 0 && errno == EINTR) continue;
+         if (received <= 0) break;
+         auto start = Clock::now();
+         pending.append(buffer, static_cast<std::size_t>(received));
+         std::size_t eol{};
+         while (!m_stopped && (eol = pending.find('\n')) != std::string::npos) {
+            response.clear();
+            if (eol > maxQueryLength) {
+               rejectLong(client, start);
+               return;
+            }
+            answer(std::string_view{pending}.substr(0, eol), response);
+            pending.erase(0, eol + 1);
+            if (!sendAll(client, response)) return;
+         }
+         if (pending.size() > maxQueryLength) {
+            rejectLong(client, start);
+            return;
+         }
+      }
+   }
+
+   static bool sendAll(int socket, std::string_view data) {
+      while (!data.empty()) {
+         ssize_t sent{::send(socket, data.data(), data.size(), MSG_NOSIGNAL)};
+         if (sent < 0) {
+            if (errno == EINTR) continue;
+            return false;
+         }
+         data.remove_prefix(static_cast<std::size_t>(sent));
+      }
+      return true;
+   }
+public:
+   // Конструктор принимает пул, уже отсортированный sortIP
+   explicit QueryServer(std::span<const IpAddress> sortedPool)
+      : m_pool{sortedPool}, m_index{sortedPool}, m_stopped{false} {}
+
+   // Конструктор по готовому индексу, например из снимка пула
+   explicit QueryServer(const PrefixIndex& index)
+      : m_pool{index.pool()}, m_index{index}, m_stopped{false} {}
+
+   // Ответ на один запрос дописывается в response. Время ответа
+   // замеряется для любого ответа, в том числе ERR и shutdown
+   void answer(std::string_view query, std::string& response) {
+      auto start = Clock::now();
+      // Отбрасываем '\r' и пробелы по краям строки
+      while (!query.empty() && (query.back() == '\r' || query.back() == ' ')) {
+         query.remove_suffix(1);
+      }
+      while (!query.empty() && query.front() == ' ') {
+         query.remove_prefix(1);
+      }
+      std::size_t space{query.find(' ')};
+      std::string_view command{query.substr(0, space)};
+      std::string_view argument{space == std::string_view::npos
+         ? std::string_view{} : query.substr(space + 1)};
+
+      if (command == "shutdown") {
+         m_stopped = true;
+         finish(response, "OK count=0", start);
+         return;
+      }
+      std::string error{};
+      std::size_t count{execute(command, argument, response, error)};
+      if (!error.empty()) {
+         finish(response, "ERR " + error, start);
+         return;
+      }
+      finish(response, "OK count=" + std::to_string(count), start);
+   }
+
+   // Ответы на запросы из потока до его окончания
+   void serve(std::istream& input, std::ostream& output) {
+      std::string response{};
+      for (std::string line; !m_stopped && std::getline(input, line);) {
+         if (line.empty()) continue;
+         response.clear();
+         answer(line, response);
+         output << response << std::flush;
+      }
+   }
+
+   // Ответы на запросы через локальный Unix-сокет.
+   // Клиенты обслуживаются по очереди до команды shutdown
+   void serveSocket(const std::string& path) {
+      sockaddr_un address{};
+      address.sun_family = AF_UNIX;
+      if (path.size() >= sizeof(address.sun_path)) {
+         throw std::invalid_argument{"слишком длинный путь сокета " + path};
+      }
+      path.copy(address.sun_path, path.size());
+      // Удаляется только оставшийся от прошлого запуска сокет: опечатка
+      // в --socket не должна стирать обычный файл
+      struct stat existing{};
+      if (::lstat(path.c_str(), &existing) == 0 && !S_ISSOCK(existing.st_mode)) {
+         throw std::system_error{std::make_error_code(std::errc::file_exists),
+            path + ": не является сокетом"};
+      }
+
+      int listener{::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+      if (listener == -1) {
+         throw std::system_error{errno, std::generic_category(), "socket"};
+      }
+      ::unlink(path.c_str());
+      if (::bind(listener, reinterpret_cast<sockaddr*>(&address),
+            sizeof(address)) == -1 || ::listen(listener, 16) == -1) {
+         int error = errno;
+         ::close(listener);
+         throw std::system_error{error, std::generic_category(), path};
+      }
+      while (!m_stopped) {
+         int client{::accept(listener, nullptr, nullptr)};
+         if (client == -1) {
+            if (errno == EINTR) continue;
+            int error = errno;
+            ::close(listener);
+            throw std::system_error{error, std::generic_category(), "accept"};
+         }
+         serveClient(client);
+         ::close(client);
+      }
+      ::close(listener);
+      ::unlink(path.c_str());
+   }
+};
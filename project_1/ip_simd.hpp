@@ -0,0 +1,127 @@
+// ip_simd.hpp -- векторное ядро фильтра "любой октет равен N"
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define IP_SIMD_X86 1
+#endif
+
+#include "ip_address.hpp"
+#include "ip_filters.hpp"
+
+// Набор инструкций, которым выполняется фильтр
+enum class SimdLevel {
+   scalar, // SWAR-проверка одного адреса за раз
+   sse2,   // 4 адреса за одно сравнение
+   avx2    // 8 адресов за одно сравнение
+};
+
+namespace detail {
+
+// Добавляет позиции адресов, у которых совпал хотя бы один байт.
+// mask -- по одному биту на байт, по 4 бита на адрес
+inline void appendMatches(std::uint32_t mask, std::size_t base,
+   IndexList& indices) {
+   while (mask != 0) {
+      unsigned address{static_cast<unsigned>(std::countr_zero(mask)) / 4};
+      indices.push_back(base + address);
+      mask &= ~(0xFu << (address * 4));
+   }
+}
+
+// Скалярная проверка по одному адресу
+inline void filterAnyScalar(const IpAddress* data, std::size_t begin,
+   std::size_t end, std::uint8_t byte, IndexList& indices) {
+   const AnyByteFilter anyByte{filter_any(byte)};
+   for (std::size_t i{begin}; i < end; ++i) {
+      if (anyByte(data[i])) indices.push_back(i);
+   }
+}
+
+#ifdef IP_SIMD_X86
+// Сравнение 16 байт (4 адресов) за одну инструкцию
+__attribute__((target("sse2")))
+inline std::size_t filterAnySse2(const IpAddress* data, std::size_t size,
+   std::uint8_t byte, IndexList& indices) {
+   const __m128i needle{_mm_set1_epi8(static_cast<char>(byte))};
+   std::size_t i{};
+   for (; i + 4 <= size; i += 4) {
+      __m128i block{_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i))};
+      auto mask = static_cast<std::uint32_t>(
+         _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)));
+      if (mask != 0) appendMatches(mask, i, indices);
+   }
+   return i;
+}
+
+// Сравнение 32 байт (8 адресов) за одну инструкцию
+__attribute__((target("avx2")))
+inline std::size_t filterAnyAvx2(const IpAddress* data, std::size_t size,
+   std::uint8_t byte, IndexList& indices) {
+   const __m256i needle{_mm256_set1_epi8(static_cast<char>(byte))};
+   std::size_t i{};
+   for (; i + 8 <= size; i += 8) {
+      __m256i block{_mm256_loadu_si256(
+         reinterpret_cast<const __m256i*>(data + i))};
+      auto mask = static_cast<std::uint32_t>(
+         _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle)));
+      if (mask != 0) appendMatches(mask, i, indices);
+   }
+   return i;
+}
+#endif
+
+} // namespace detail
+
+// Лучший набор инструкций, доступный на текущем процессоре.
+// Определяется один раз при первом обращении
+inline SimdLevel detectSimdLevel() noexcept {
+#ifdef IP_SIMD_X86
+   static const SimdLevel level = [] {
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2")) return SimdLevel::avx2;
+      if (__builtin_cpu_supports("sse2")) return SimdLevel::sse2;
+      return SimdLevel::scalar;
+   }();
+   return level;
+#else
+   return SimdLevel::scalar;
+#endif
+}
+
+// Позиции адресов пула, у которых любой октет равен byte.
+// Позиции возвращаются по возрастанию, как у последовательного прохода
+inline IndexList filterAnyByte(std::span<const IpAddress> ipPool,
+   std::uint8_t byte, SimdLevel level = detectSimdLevel()) {
+   IndexList indices{};
+   std::size_t done{};
+#ifdef IP_SIMD_X86
+   switch (level) {
+   case SimdLevel::avx2:
+      done = detail::filterAnyAvx2(ipPool.data(), ipPool.size(), byte, indices);
+      break;
+   case SimdLevel::sse2:
+      done = detail::filterAnySse2(ipPool.data(), ipPool.size(), byte, indices);
+      break;
+   case SimdLevel::scalar:
+      break;
+   }
+#else
+   (void)level;
+#endif
+   // Хвост, не кратный ширине регистра, проверяется скалярно
+   detail::filterAnyScalar(ipPool.data(), done, ipPool.size(), byte, indices);
+   return indices;
+}
+
+// Позиции адресов пула, прошедших фильтр filter_any(byte)
+inline IndexList filterAnyByte(std::span<const IpAddress> ipPool,
+   AnyByteFilter filter, SimdLevel level = detectSimdLevel()) {
+   return filterAnyByte(ipPool, filter.byte(), level);
+}
@@ -0,0 +1,172 @@
+// ip_snapshot.hpp -- двоичный снимок отсортированного пула ip-адресов
+
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <sys/mman.h>
+
+#include "ip_address.hpp"
+#include "ip_index.hpp"
+#include "ip_reader.hpp"
+
+// Формат снимка: заголовок SnapshotHeader, сразу за ним count упакованных
+// адресов по 4 байта в порядке байтов машины, записавшей снимок.
+// Адреса отсортированы в обратном лексикографическом порядке, заголовок
+// хранит таблицу смещений PrefixIndex, поэтому после отображения файла
+// в память запросы выполняются сразу, без разбора и сортировки
+inline constexpr std::array<char, 8> snapshotMagic{'I', 'P', 'S', 'N', 'A', 'P', 0, 0};
+inline constexpr std::uint32_t snapshotVersion{1};
+// Записывается как есть; при другом порядке байтов читается иначе
+inline constexpr std::uint32_t snapshotByteOrder{0x01020304};
+
+struct SnapshotHeader {
+   std::array<char, 8> magic;               // snapshotMagic
+   std::uint32_t version;                   // snapshotVersion
+   std::uint32_t byteOrder;                 // snapshotByteOrder
+   std::uint64_t count;                     // Число адресов
+   std::array<std::uint64_t, 257> offsets;  // Таблица смещений индекса
+   std::uint64_t dataChecksum;              // Контрольная сумма адресов
+   std::uint64_t headerChecksum;            // Контрольная сумма полей выше
+};
+
+static_assert(std::is_trivially_copyable_v<SnapshotHeader>);
+// Адреса за заголовком выровнены на 8 байт
+static_assert(sizeof(SnapshotHeader) % 8 == 0);
+static_assert(std::is_trivially_copyable_v<IpAddress>);
+
+// Контрольная сумма FNV-1a по байтам
+inline std::uint64_t fnv1a(const void* data, std::size_t size) noexcept {
+   const auto* bytes = static_cast<const unsigned char*>(data);
+   std::uint64_t hash{0xcbf29ce484222325ull};
+   for (std::size_t i{}; i < size; ++i) {
+      hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+   }
+   return hash;
+}
+
+// Контрольная сумма адресов: FNV-1a по 32-битным словам, вчетверо
+// меньше умножений, чем по байтам
+inline std::uint64_t snapshotChecksum(std::span<const IpAddress> pool) noexcept {
+   std::uint64_t hash{0xcbf29ce484222325ull};
+   for (IpAddress ip : pool) {
+      hash = (hash ^ ip.value()) * 0x100000001b3ull;
+   }
+   return hash;
+}
+
+// Запись снимка пула, отсортированного sortIP.
+// Снимок пишется во временный файл и затем заменяет прежний
+inline void writeSnapshot(const std::string& path,
+   std::span<const IpAddress> sortedPool) {
+   const PrefixIndex index{sortedPool};
+   SnapshotHeader header{};
+   header.magic = snapshotMagic;
+   header.version = snapshotVersion;
+   header.byteOrder = snapshotByteOrder;
+   header.count = sortedPool.size();
+   for (std::size_t i{}; i < header.offsets.size(); ++i) {
+      header.offsets[i] = index.offsets()[i];
+   }
+   header.dataChecksum = snapshotChecksum(sortedPool);
+   header.headerChecksum = fnv1a(&header,
+      offsetof(SnapshotHeader, headerChecksum));
+
+   const std::string temporary{path + ".tmp"};
+   FileHandle file{std::fopen(temporary.c_str(), "wb")};
+   if (!file
+      || std::fwrite(&header, sizeof(header), 1, file.get()) != 1
+      || std::fwrite(sortedPool.data(), sizeof(IpAddress), sortedPool.size(),
+         file.get()) != sortedPool.size()
+      || std::fclose(file.release()) != 0) {
+      throw std::system_error{errno, std::generic_category(), temporary};
+   }
+   if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+      throw std::system_error{errno, std::generic_category(), path};
+   }
+}
+
+// Снимок, открытый через отображение в память.
+// При открытии проверяются сигнатура, версия, порядок байтов, контрольная
+// сумма заголовка, размер файла и таблица смещений -- это не зависит от
+// числа адресов. Полная проверка контрольной суммы адресов читает весь
+// файл, поэтому выполняется только по запросу
+class Snapshot {
+private:
+   MappedFile m_file;    // Отображение файла
+   PrefixIndex m_index;  // Индекс по адресам снимка
+
+   // Проверенный заголовок снимка
+   static const SnapshotHeader& header(const MappedFile& file,
+      const std::string& path) {
+      auto fail = [&path](const char* what) {
+         throw std::runtime_error{path + ": " + what};
+      };
+      std::string_view data{file.data()};
+      if (data.size() < sizeof(SnapshotHeader)) fail("не является снимком пула");
+      // Отображение выровнено по странице, заголовок читается на месте
+      const auto& header = *reinterpret_cast<const SnapshotHeader*>(data.data());
+      if (header.magic != snapshotMagic) fail("не является снимком пула");
+      if (header.byteOrder != snapshotByteOrder) fail("другой порядок байтов");
+      if (header.version != snapshotVersion) fail("неподдерживаемая версия снимка");
+      if (header.headerChecksum != fnv1a(&header,
+            offsetof(SnapshotHeader, headerChecksum))) {
+         fail("повреждён заголовок снимка");
+      }
+      if ((data.size() - sizeof(SnapshotHeader)) / sizeof(IpAddress) != header.count
+         || (data.size() - sizeof(SnapshotHeader)) % sizeof(IpAddress) != 0) {
+         fail("размер файла не совпадает с заголовком");
+      }
+      for (std::size_t i{}; i < 256; ++i) {
+         if (header.offsets[i] > header.offsets[i + 1]) fail("неверная таблица смещений");
+      }
+      if (header.offsets[0] != 0 || header.offsets[256] != header.count) {
+         fail("неверная таблица смещений");
+      }
+      return header;
+   }
+
+   static PrefixIndex makeIndex(const MappedFile& file, const std::string& path) {
+      const SnapshotHeader& info = header(file, path);
+      const auto* addresses = reinterpret_cast<const IpAddress*>(
+         file.data().data() + sizeof(SnapshotHeader));
+      std::array<std::size_t, 257> offsets{};
+      for (std::size_t i{}; i < offsets.size(); ++i) {
+         offsets[i] = static_cast<std::size_t>(info.offsets[i]);
+      }
+      return PrefixIndex{{addresses, static_cast<std::size_t>(info.count)}, offsets};
+   }
+public:
+   // Открытие снимка. verify -- дополнительно сверить контрольную сумму
+   // всех адресов. advice -- порядок доступа для madvise: полный вывод
+   // читает адреса подряд, а сервер запросов обращается к частям снимка
+   // вразнобой и передаёт MADV_RANDOM
+   explicit Snapshot(const std::string& path, bool verify = false,
+      int advice = MADV_SEQUENTIAL)
+      : m_file{path, advice}, m_index{makeIndex(m_file, path)} {
+         if (verify && snapshotChecksum(m_index.pool())
+               != header(m_file, path).dataChecksum) {
+            throw std::runtime_error{path + ": повреждены адреса снимка"};
+         }
+   }
+
+   // Отсортированный пул
+   std::span<const IpAddress> pool() const noexcept {
+      return m_index.pool();
+   }
+
+   // Индекс по пулу, построенный при записи снимка
+   const PrefixIndex& index() const noexcept {
+      return m_index;
+   }
+};
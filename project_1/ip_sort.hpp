@@ -0,0 +1,194 @@
+// ip_sort.hpp -- сортировка ip-адресов в обратном лексикографическом порядке
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ip_address.hpp"
+
+// Способ сортировки пула адресов
+enum class SortEngine {
+   comparison, // std::ranges::sort со сравнением адресов
+   radix,      // поразрядная LSD-сортировка по октетам
+   parallel    // параллельная поразрядная сортировка
+};
+
+// Способ сортировки по имени из командной строки
+inline SortEngine sortEngineFromString(const std::string& name) {
+   if (name == "std") return SortEngine::comparison;
+   if (name == "radix") return SortEngine::radix;
+   if (name == "parallel") return SortEngine::parallel;
+   throw std::invalid_argument{"неизвестный способ сортировки " + name};
+}
+
+// Ключ сортировки по умолчанию -- упакованное значение адреса
+struct IpKey {
+   std::uint32_t operator()(IpAddress ip) const noexcept {
+      return ip.value();
+   }
+};
+
+namespace detail {
+
+// Проходы устойчивой сортировки подсчётом по октетам ключа [first, last),
+// начиная с младшего. Элементы перекладываются между src и dst,
+// возвращается указатель на тот из массивов, где лежит результат
+template<typename T, typename Key>
+T* radixPasses(T* src, T* dst, std::size_t n, Key key,
+   unsigned first, unsigned last) {
+   // Гистограммы всех четырёх октетов за один проход
+   std::array<std::array<std::size_t, 256>, 4> counts{};
+   for (std::size_t i{}; i < n; ++i) {
+      std::uint32_t k{key(src[i])};
+      ++counts[0][k & 0xFF];
+      ++counts[1][(k >> 8) & 0xFF];
+      ++counts[2][(k >> 16) & 0xFF];
+      ++counts[3][k >> 24];
+   }
+
+   for (unsigned pass{first}; pass < last; ++pass) {
+      const auto& count = counts[pass];
+      // Если октет одинаков у всех ключей, проход ничего не меняет
+      if (std::ranges::find(count, n) != count.end()) continue;
+      // По убыванию: корзина 255 идёт первой
+      std::array<std::size_t, 256> position{};
+      std::size_t offset{};
+      for (std::size_t digit{256}; digit-- > 0;) {
+         position[digit] = offset;
+         offset += count[digit];
+      }
+      const unsigned shift{pass * 8};
+      for (std::size_t i{}; i < n; ++i) {
+         dst[position[(key(src[i]) >> shift) & 0xFF]++] = src[i];
+      }
+      std::swap(src, dst);
+   }
+   return src;
+}
+
+} // namespace detail
+
+// Поразрядная LSD-сортировка по убыванию 32-битного ключа.
+// Четыре прохода подсчётом по одному октету, начиная с младшего.
+// Сортировка устойчива: равные ключи сохраняют исходный порядок
+template<typename T, typename Key = IpKey>
+void radixSortDescending(std::vector<T>& data, Key key = {}) {
+   const std::size_t n{data.size()};
+   if (n < 2) return;
+   std::vector<T> buffer(n);
+   T* result{detail::radixPasses(data.data(), buffer.data(), n, key, 0, 4)};
+   // После нечётного числа проходов результат лежит во временном буфере
+   if (result != data.data()) {
+      std::copy(result, result + n, data.data());
+   }
+}
+
+// Параллельная поразрядная сортировка по убыванию, результат совпадает
+// с radixSortDescending, включая порядок равных ключей.
+// 1. Каждый поток строит гистограмму старшего октета по своей части.
+// 2. Каждый поток раскладывает свою часть по 256 корзинам старшего октета;
+//    смещения потоков внутри корзины идут в порядке частей, что сохраняет
+//    устойчивость.
+// 3. Корзины независимы и досортировываются по трём младшим октетам;
+//    потоки забирают корзины по одной через общий атомарный счётчик,
+//    поэтому неравные по размеру корзины распределяются динамически
+template<typename T, typename Key = IpKey>
+void radixSortDescendingParallel(std::vector<T>& data, unsigned threads,
+   Key key = {}) {
+   const std::size_t n{data.size()};
+   // На малых объёмах запуск потоков дороже самой сортировки
+   constexpr std::size_t minParallelSize{1 << 16};
+   if (threads <= 1 || n < minParallelSize) {
+      radixSortDescending(data, key);
+      return;
+   }
+
+   std::vector<T> buffer(n);
+   std::vector<std::array<std::size_t, 256>> counts(threads);
+   auto partBegin = [n, threads](unsigned part) {
+      return n * part / threads;
+   };
+   // Запуск задачи во всех потоках и ожидание их завершения
+   auto parallel = [threads](auto&& task) {
+      std::vector<std::jthread> workers{};
+      workers.reserve(threads);
+      for (unsigned t{}; t < threads; ++t) {
+         workers.emplace_back(task, t);
+      }
+   };
+
+   // Гистограммы старшего октета по частям
+   parallel([&](unsigned t) {
+      auto& count = counts[t];
+      count.fill(0);
+      for (std::size_t i{partBegin(t)}; i < partBegin(t + 1); ++i) {
+         ++count[key(data[i]) >> 24];
+      }
+   });
+
+   // Смещения частей в корзинах: корзина 255 первая, внутри корзины
+   // части по порядку
+   std::vector<std::array<std::size_t, 256>> positions(threads);
+   std::array<std::size_t, 257> bucketBegin{};
+   std::size_t offset{};
+   for (std::size_t digit{256}; digit-- > 0;) {
+      bucketBegin[255 - digit] = offset;
+      for (unsigned t{}; t < threads; ++t) {
+         positions[t][digit] = offset;
+         offset += counts[t][digit];
+      }
+   }
+   bucketBegin[256] = n;
+
+   // Раскладка по корзинам старшего октета
+   parallel([&](unsigned t) {
+      auto& position = positions[t];
+      for (std::size_t i{partBegin(t)}; i < partBegin(t + 1); ++i) {
+         buffer[position[key(data[i]) >> 24]++] = data[i];
+      }
+   });
+
+   // Досортировка корзин по трём младшим октетам
+   std::atomic<std::size_t> nextBucket{0};
+   parallel([&](unsigned) {
+      for (std::size_t bucket; (bucket = nextBucket.fetch_add(1)) < 256;) {
+         const std::size_t begin{bucketBegin[bucket]};
+         const std::size_t size{bucketBegin[bucket + 1] - begin};
+         if (size == 0) continue;
+         T* result{detail::radixPasses(buffer.data() + begin,
+            data.data() + begin, size, key, 0, 3)};
+         if (result != data.data() + begin) {
+            std::copy(result, result + size, data.data() + begin);
+         }
+      }
+   });
+}
+
+// Сортировка пула адресов выбранным способом.
+// threads -- число потоков параллельной сортировки
+inline void sortIP(std::vector<IpAddress>& ipPool,
+   SortEngine engine = SortEngine::comparison, unsigned threads = 1) {
+   switch (engine) {
+   case SortEngine::parallel:
+      radixSortDescendingParallel(ipPool, threads);
+      break;
+   case SortEngine::radix:
+      radixSortDescending(ipPool);
+      break;
+   case SortEngine::comparison:
+   default:
+      // Сравнение упакованных адресов -- одно сравнение целых чисел
+      std::ranges::sort(ipPool, std::ranges::greater{});
+      break;
+   }
+}
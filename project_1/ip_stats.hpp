@@ -0,0 +1,115 @@
+// ip_stats.hpp -- замеры времени этапов и счётчики обработки (--stats)
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+
+namespace detail {
+
+// Счётчики выделений памяти. Увеличиваются заменёнными operator new и
+// operator delete программы, собранной с -DIP_FILTER_COUNT_ALLOCATIONS;
+// без этого отчёт их не содержит
+inline std::atomic<std::size_t> allocations{0};
+inline std::atomic<std::size_t> deallocations{0};
+
+} // namespace detail
+
+// Объём и число строк разобранного текста
+struct InputStats {
+   std::size_t lines{};     // Прочитано строк
+   std::size_t bytes{};     // Разобрано байт
+   std::size_t rejected{};  // Непустых строк без корректного адреса
+};
+
+// Отчёт о работе программы: время этапов и счётчики.
+// Выключенный отчёт ничего не замеряет: этап -- одна проверка флага
+// в начале и в конце, счётчики по строкам не ведутся
+class Stats {
+private:
+   using Clock = std::chrono::steady_clock;
+
+   bool m_enabled;  // Отчёт нужен
+   std::vector<std::pair<std::string, double>> m_stages; // Этап и время, мс
+public:
+   InputStats input{};           // Разобранный текст
+   std::size_t addresses{};      // Корректных адресов в пуле
+   std::size_t bytesWritten{};   // Выведено байт
+
+   // Замер одного этапа от создания до уничтожения объекта
+   class Stage {
+   private:
+      Stats* m_stats;            // Отчёт, nullptr -- замер выключен
+      std::string_view m_name;   // Название этапа
+      Clock::time_point m_start; // Начало этапа
+   public:
+      Stage(Stats* stats, std::string_view name) noexcept
+         : m_stats{stats}, m_name{name},
+         m_start{stats ? Clock::now() : Clock::time_point{}} {}
+
+      ~Stage() {
+         if (!m_stats) return;
+         std::chrono::duration<double, std::milli> elapsed{
+            Clock::now() - m_start};
+         m_stats->m_stages.emplace_back(m_name, elapsed.count());
+      }
+
+      // Копирующий конструктор запрещён
+      Stage(const Stage&) = delete;
+
+      // Конструктор копирующего присваивания запрещён
+      Stage& operator=(const Stage&) = delete;
+   };
+
+   explicit Stats(bool enabled = false) : m_enabled{enabled}, m_stages{} {}
+
+   bool enabled() const noexcept {
+      return m_enabled;
+   }
+
+   // Замер этапа: auto timer = stats.stage("sort");
+   [[nodiscard]] Stage stage(std::string_view name) noexcept {
+      return Stage{m_enabled ? this : nullptr, name};
+   }
+
+   // Отчёт одной строкой JSON. Отброшенные строки -- непустые строки,
+   // в которых не разобран адрес; пиковый объём памяти -- ru_maxrss процесса
+   void report(std::ostream& output) const {
+      if (!m_enabled) return;
+      rusage usage{};
+      ::getrusage(RUSAGE_SELF, &usage);
+      std::string json{"{\"stages_ms\":{"};
+      char number[32];
+      for (std::size_t i{}; i < m_stages.size(); ++i) {
+         std::snprintf(number, sizeof(number), "%.3f", m_stages[i].second);
+         json += (i == 0 ? "\"" : ",\"") + m_stages[i].first + "\":" + number;
+      }
+      auto field = [&json](const char* name, std::size_t value) {
+         json += ",\"";
+         json += name;
+         json += "\":" + std::to_string(value);
+      };
+      json += '}';
+      field("lines_read", input.lines);
+      field("lines_rejected", input.rejected);
+      field("addresses", addresses);
+      field("bytes_parsed", input.bytes);
+      field("bytes_written", bytesWritten);
+      field("peak_rss_kb", static_cast<std::size_t>(usage.ru_maxrss));
+#ifdef IP_FILTER_COUNT_ALLOCATIONS
+      field("allocations", detail::allocations.load(std::memory_order_relaxed));
+      field("deallocations", detail::deallocations.load(std::memory_order_relaxed));
+#endif
+      json += "}\n";
+      output << json << std::flush;
+   }
+};
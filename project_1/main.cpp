@@ -2,107 +2,465 @@
 // Файл исходного кода обработки ip-адресов
 
 #include <iostream>
+#include <fstream>
 #include <vector>
 #include <string>
+#include <optional>
 #include <ranges>
 #include <algorithm>
-#include <cctype>
-
-// Функция разбивает строку по разделителю
-// Здесь возвращаемое значение std::vector<std::string>
-auto split(const std::string& string, char delimiter) {
-   std::vector<std::string> delString{};
-   if (string == "") return delString;
-   std::size_t start{0};   // Стартовая позиция
-   std::size_t stop{string.find(delimiter)}; // Позиция останова
-   while (stop != std::string::npos) {
-      delString.emplace_back(string.substr(start, stop - start));
-      start = stop + 1;
-      stop = string.find(delimiter, start);
-   }
-   delString.emplace_back(string.substr(start));
-   return delString;
+#include <cstdlib>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include "ip_address.hpp"
+#include "ip_aggregate.hpp"
+#include "ip_external.hpp"
+#include "ip_filters.hpp"
+#include "ip_incremental.hpp"
+#include "ip_index.hpp"
+#include "ip_output.hpp"
+#include "ip_reader.hpp"
+#include "ip_server.hpp"
+#include "ip_simd.hpp"
+#include "ip_snapshot.hpp"
+#include "ip_stats.hpp"
+#include "ip_sort.hpp"
+
+#ifdef IP_FILTER_COUNT_ALLOCATIONS
+// Подсчёт выделений памяти для отчёта --stats: одно атомарное
+// увеличение счётчика на вызов, без блокировок. Замена operator new
+// есть только в отдельной сборке с -DIP_FILTER_COUNT_ALLOCATIONS, чтобы
+// обычная сборка не платила за счётчики на каждом выделении
+void* operator new(std::size_t size) {
+   detail::allocations.fetch_add(1, std::memory_order_relaxed);
+   if (void* memory = std::malloc(size == 0 ? 1 : size)) return memory;
+   throw std::bad_alloc{};
+}
+
+void operator delete(void* memory) noexcept {
+   if (memory) detail::deallocations.fetch_add(1, std::memory_order_relaxed);
+   std::free(memory);
 }
 
+void operator delete(void* memory, std::size_t) noexcept {
+   ::operator delete(memory);
+}
+#endif
+
 // Функция отображает список IP-адресов
 // Один адрес в одной строке
-void displayIP(const std::vector<std::vector<std::string>>& ipPoolRef) {
-   for (const auto& addressLine : ipPoolRef) {
-      for (const auto& address : addressLine) {
-         std::cout << address << '.';
-      }
-      std::cout << "\b \n";
+void displayIP(IpWriter& out, std::span<const IpAddress> ipPoolRef) {
+   out.write(ipPoolRef);
+}
+
+// Функция отображает выбранные адреса пула
+// indices -- позиции адресов в пуле
+void displayIP(IpWriter& out, std::span<const IpAddress> ipPoolRef,
+   const IndexList& indices) {
+   for (std::size_t index : indices) {
+      out.write(ipPoolRef[index]);
    }
 }
 
-int main() {
-   std::vector<std::vector<std::string>> ipPool{};
-   for (std::string line; std::cin >> line;) {
-      ipPool.emplace_back(split(line, '.'));
-      while (std::cin.get() != '\n') {
-         continue;
-      }
-   }
-
-   // Проверяем исходный вектор на корректность ip-адресов
-   // если ip-адрес не корректен удаляем его из списка
-   auto invalidIP = [](const std::vector<std::string>& ipLines) {
-      // Проверяем количество октетов
-      if (ipLines.size() != 4) return true;
-      //Проверяем каждый октет на содержание только цифр
-      for (const auto& octet : ipLines) {
-         if (std::ranges::any_of(octet, 
-            [](char ch){return !std::isdigit(ch);})) return true;
-         // Проверка октетов на соответствие диапазону [0-255]
-         if (std::stoi(octet) < 0 || std::stoi(octet) > 255) return true;
-      }  
-      return false;         
-   };
-   std::erase_if(ipPool, invalidIP);
-   
-   // Обратная лексикографическая сортировка
-   // Определяем именованную лямбду
-   auto compareIP = [](const std::vector<std::string>& ip1,
-      const std::vector<std::string>& ip2) {
-         for (int i{}; i < 4; ++i) {
-            int octetIp1 = std::stoi(ip1[i]);
-            int octetIp2 = std::stoi(ip2[i]);
-            if (octetIp1 != octetIp2) {
-               return octetIp1 > octetIp2;
-            }
+// Загрузка ip-адресов из стандартного ввода
+// Каждый адрес разбирается и проверяется один раз при загрузке,
+// некорректные ip-адреса в список не попадают.
+// stats -- если задан, в него добавляются объём и число строк
+std::vector<IpAddress> loadStream(std::istream& input,
+   InputStats* stats = nullptr) {
+   std::vector<IpAddress> ipPool{};
+   InputStats read{};
+   for (std::string line; std::getline(input, line);) {
+      auto ip = parseIP(firstField(line));
+      if (ip) ipPool.push_back(*ip);
+      countLine(read, line, ip.has_value());
+   }
+   if (stats) {
+      stats->lines += read.lines;
+      stats->bytes += read.bytes;
+      stats->rejected += read.rejected;
+   }
+   return ipPool;
+}
+
+// Открытие текстового файла для чтения потоком
+std::ifstream openStream(const std::string& path) {
+   std::ifstream input{path};
+   if (!input) {
+      throw std::system_error{errno, std::generic_category(), path};
+   }
+   return input;
+}
+
+// Параметры командной строки
+struct Options {
+   std::string path{};  // Файл для отображения в память, пусто -- stdin
+   unsigned threads{1}; // Число потоков разбора файла и сортировки
+   SortEngine sort{SortEngine::comparison}; // Способ сортировки
+   bool serve{false};   // Отвечать на запросы вместо вывода списков
+   std::string socket{}; // Unix-сокет для запросов, пусто -- stdin
+   std::size_t memoryLimit{}; // Предел памяти внешней сортировки, 0 -- без неё
+   bool aggregate{false}; // Итоги по адресам вместо вывода списков
+   std::string base{};  // Файл пула для пополнения, пусто -- без него
+   std::string snapshot{}; // Снимок пула вместо разбора текста
+   std::string snapshotOut{}; // Куда записать снимок отсортированного пула
+   bool verify{false};  // Сверить контрольную сумму адресов снимка
+   bool stats{false};   // Отчёт о времени этапов в stderr
+};
+
+// Разбор параметров командной строки
+// Запуск: ./a.out < ip_filter.tsv -- чтение из стандартного ввода
+//         ./a.out ip_filter.tsv   -- чтение файла через отображение в память
+//         --threads N             -- разбор файла и параллельная сортировка
+//                                    в N потоков, N от 1 до 8 на ядро
+//         --sort std|radix|parallel -- сортировка сравнением, поразрядная
+//                                    или параллельная поразрядная
+//         --serve                 -- ответы на запросы из стандартного ввода
+//         --socket PATH           -- ответы на запросы через Unix-сокет
+//         --mem-limit SIZE        -- внешняя сортировка в пределах SIZE байт
+//                                    (допустимы суффиксы K, M, G)
+//         --aggregate             -- итоги по различным адресам: число строк
+//                                    и суммы полей text2, text3
+//         --base FILE             -- пополнение сохранённого в FILE пула
+//                                    новыми адресами без полной сортировки
+//         --write-snapshot FILE   -- записать снимок отсортированного пула
+//         --snapshot FILE         -- открыть снимок вместо разбора и сортировки
+//         --verify                -- сверить контрольную сумму адресов снимка
+//         --stats                 -- отчёт JSON о времени этапов, числе
+//                                    строк, байт и памяти в stderr
+Options parseOptions(int argc, char* argv[]) {
+   Options options{};
+   for (int i{1}; i < argc; ++i) {
+      std::string arg{argv[i]};
+      // Значение параметра -- следующий аргумент
+      auto value = [&]() -> std::string {
+         if (++i == argc) {
+            throw std::invalid_argument{arg + ": требуется значение"};
          }
-         return false;
-   };
-   // С помощью алгоритма сортировки сортируем ip-адреса
-   std::ranges::sort(ipPool, compareIP);
-   // Отображаем отсортированный список ip-адресов
-   displayIP(ipPool);
-
-   // Фильтрация первому байту
-   std::vector<std::vector<std::string>> temp{};
-   std::ranges::copy_if(ipPool, std::back_inserter(temp), 
-      [](const std::vector<std::string>& ip){return ip[0] == "1";});
-   // Отображаем выбранный список
-   displayIP(temp);
-
-   // Фильтрация по первому и второму байтам
-   // Первый байт = 46, второй байт = 70
-   auto filterOneTwo = [](const std::vector<std::string>& ip) {
-      return (ip[0] == "46" && ip[1] == "70");
+         return argv[i];
+      };
+      if (arg == "--threads") {
+         options.threads = parseThreadCount(value());
+      }
+      else if (arg == "--sort") {
+         options.sort = sortEngineFromString(value());
+      }
+      else if (arg == "--serve") {
+         options.serve = true;
+      }
+      else if (arg == "--socket") {
+         options.serve = true;
+         options.socket = value();
+      }
+      else if (arg == "--mem-limit") {
+         options.memoryLimit = parseMemoryLimit(value());
+      }
+      else if (arg == "--aggregate") {
+         options.aggregate = true;
+      }
+      else if (arg == "--base") {
+         options.base = value();
+      }
+      else if (arg == "--snapshot") {
+         options.snapshot = value();
+      }
+      else if (arg == "--write-snapshot") {
+         options.snapshotOut = value();
+      }
+      else if (arg == "--verify") {
+         options.verify = true;
+      }
+      else if (arg == "--stats") {
+         options.stats = true;
+      }
+      else if (arg.starts_with("--")) {
+         throw std::invalid_argument{"неизвестный параметр " + arg};
+      }
+      else {
+         options.path = arg;
+      }
+   }
+   if (options.serve && options.memoryLimit != 0) {
+      throw std::invalid_argument{"--mem-limit несовместим с режимом сервера"};
+   }
+   if (options.aggregate && (options.serve || options.memoryLimit != 0)) {
+      throw std::invalid_argument{"--aggregate несовместим с --serve и --mem-limit"};
+   }
+   if (!options.base.empty()
+      && (options.serve || options.memoryLimit != 0 || options.aggregate)) {
+      throw std::invalid_argument{
+         "--base несовместим с --serve, --mem-limit и --aggregate"};
+   }
+   const bool otherModes{options.memoryLimit != 0 || options.aggregate
+      || !options.base.empty()};
+   if (!options.snapshot.empty()
+      && (otherModes || !options.path.empty() || !options.snapshotOut.empty())) {
+      throw std::invalid_argument{"--snapshot несовместим с файлом адресов "
+         "и другими режимами"};
+   }
+   if (!options.snapshotOut.empty() && (otherModes || options.serve)) {
+      throw std::invalid_argument{"--write-snapshot несовместим с другими режимами"};
+   }
+   return options;
+}
+
+// Загрузка адресов из options.path или стандартного ввода. Обычный файл
+// отображается в память, канал или подстановка процесса читаются потоком
+std::vector<IpAddress> loadInput(const Options& options, InputStats* input) {
+   if (options.path.empty()) return loadStream(std::cin, input);
+   if (isRegularFile(options.path)) {
+      return loadFile(options.path, options.threads, input);
+   }
+   std::ifstream stream{openStream(options.path)};
+   return loadStream(stream, input);
+}
+
+// Итоги по адресам: строки загружаются вместе со счётчиками,
+// повторы адресов сворачиваются после сортировки.
+// Счётчики отчёта --stats заполняются, если он включён
+void aggregateAddresses(const Options& options, Stats& stats) {
+   InputStats* input{stats.enabled() ? &stats.input : nullptr};
+   AddressColumns columns{};
+   auto load = [&columns, input](std::istream& stream) {
+      for (std::string line; std::getline(stream, line);) {
+         bool parsed{parseRecord(line, columns)};
+         if (input) countLine(*input, line, parsed);
+      }
    };
-   temp.clear();
-   std::ranges::copy_if(ipPool, std::back_inserter(temp), filterOneTwo);
-   // Отображаем отфильтрованный список
-   displayIP(temp);
-
-   // Фильтрация списка по любому байту, который равен 46
-   auto anyByteFilter = [](const std::vector<std::string>& ip) {
-      return (ip[0] == "46" || ip[1] == "46" 
-            || ip[2] == "46" || ip[3] == "46");
+   if (options.path.empty()) {
+      load(std::cin);
+   }
+   else if (isRegularFile(options.path)) {
+      columns = loadColumns(options.path, input);
+   }
+   else {
+      std::ifstream stream{openStream(options.path)};
+      load(stream);
+   }
+   IpWriter out{};
+   writeTotals(out, aggregate(columns, options.threads));
+   out.flush();
+   stats.addresses = columns.size();
+   stats.bytesWritten = out.bytesWritten();
+}
+
+// Пополнение сохранённого пула: сортируются только новые адреса,
+// пул и разделы вывода обновляются слиянием, затем пул сохраняется.
+// Счётчики отчёта --stats заполняются, если он включён
+void appendToBase(const Options& options, Stats& stats) {
+   InputStats* input{stats.enabled() ? &stats.input : nullptr};
+   IncrementalPool pool{IncrementalPool::load(options.base)};
+   pool.append(loadInput(options, input), options.sort, options.threads);
+   pool.save(options.base);
+
+   IpWriter out{};
+   displayIP(out, pool.pool());
+   displayIP(out, pool.find(filter(1)));
+   displayIP(out, pool.find(filter(46, 70)));
+   displayIP(out, pool.anyByte());
+   out.flush();
+   stats.addresses = pool.pool().size();
+   stats.bytesWritten = out.bytesWritten();
+}
+
+// Внешняя сортировка: пул целиком в памяти не хранится.
+// Строки читаются потоком, отсортированные порции сохраняются во временные
+// файлы и сливаются. Отфильтрованные списки при слиянии тоже уходят во
+// временные файлы и выводятся следом за полным списком.
+// Счётчики отчёта --stats заполняются, если он включён
+void sortExternal(const Options& options, Stats& stats) {
+   // Буфер вывода и буферы трёх отфильтрованных списков входят в предел
+   // памяти: на каждый до 1/16 предела, остальное -- сортировщику
+   const std::size_t outputBytes{
+      std::min(options.memoryLimit / 16, std::size_t{1} << 20)};
+   ExternalSorter sorter{options.memoryLimit - 4 * outputBytes};
+   InputStats* counted{stats.enabled() ? &stats.input : nullptr};
+   auto load = [&sorter, counted](std::istream& input) {
+      for (std::string line; std::getline(input, line);) {
+         auto ip = parseIP(firstField(line));
+         if (ip) sorter.add(*ip);
+         if (counted) countLine(*counted, line, ip.has_value());
+      }
    };
-   temp.clear();
-   std::string anyByte{"46"};
-   std::ranges::copy_if(ipPool, std::back_inserter(temp), anyByteFilter);
-   // Отображаем отфильтрованный список
-   displayIP(temp);
-}
\ No newline at end of file
+   if (options.path.empty()) {
+      load(std::cin);
+   }
+   else {
+      std::ifstream input{openStream(options.path)};
+      load(input);
+   }
+
+   constexpr auto filterOne = filter(1);
+   constexpr auto filterOneTwo = filter(46, 70);
+   constexpr auto anyByteFilter = filter_any(46);
+   RunFile firstByte{outputBytes / sizeof(IpAddress)};
+   RunFile firstTwoBytes{outputBytes / sizeof(IpAddress)};
+   RunFile anyByte{outputBytes / sizeof(IpAddress)};
+   IpWriter out{STDOUT_FILENO, outputBytes};
+   sorter.merge([&](IpAddress ip) {
+      out.write(ip);
+      if (filterOne(ip)) firstByte.push(ip);
+      if (filterOneTwo(ip)) firstTwoBytes.push(ip);
+      if (anyByteFilter(ip)) anyByte.push(ip);
+   });
+   for (RunFile* section : {&firstByte, &firstTwoBytes, &anyByte}) {
+      section->forEach([&out](IpAddress ip) { out.write(ip); });
+   }
+   out.flush();
+   stats.addresses = sorter.size();
+   stats.bytesWritten = out.bytesWritten();
+}
+
+int main(int argc, char* argv[]) {
+   Options options{};
+   std::vector<IpAddress> ipPool{};
+   std::optional<Snapshot> snapshot{};
+   Stats stats{};
+   try {
+      options = parseOptions(argc, argv);
+      stats = Stats{options.stats};
+      // Отдельные режимы замеряются одним этапом
+      if (options.memoryLimit != 0) {
+         {
+            auto timer = stats.stage("external_sort");
+            sortExternal(options, stats);
+         }
+         stats.report(std::cerr);
+         return 0;
+      }
+      if (options.aggregate) {
+         {
+            auto timer = stats.stage("aggregate");
+            aggregateAddresses(options, stats);
+         }
+         stats.report(std::cerr);
+         return 0;
+      }
+      if (!options.base.empty()) {
+         {
+            auto timer = stats.stage("append");
+            appendToBase(options, stats);
+         }
+         stats.report(std::cerr);
+         return 0;
+      }
+      if (!options.snapshot.empty()) {
+         // Снимок уже отсортирован и проиндексирован. Полный вывод читает
+         // его подряд, сервер -- вразнобой
+         auto timer = stats.stage("open_snapshot");
+         snapshot.emplace(options.snapshot, options.verify,
+            options.serve ? MADV_RANDOM : MADV_SEQUENTIAL);
+      }
+      else {
+         // Разбор вместе с проверкой адресов
+         auto timer = stats.stage("parse");
+         InputStats* input{stats.enabled() ? &stats.input : nullptr};
+         ipPool = loadInput(options, input);
+      }
+   }
+   catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+   }
+
+   if (!snapshot) {
+      // Обратная лексикографическая сортировка выбранным способом
+      {
+         auto timer = stats.stage("sort");
+         sortIP(ipPool, options.sort, options.threads);
+      }
+
+      // Преобразование в снимок: дальнейшие запуски открывают его
+      // без разбора и сортировки
+      if (!options.snapshotOut.empty()) {
+         try {
+            auto timer = stats.stage("write_snapshot");
+            writeSnapshot(options.snapshotOut, ipPool);
+         }
+         catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+         }
+         stats.addresses = ipPool.size();
+         stats.report(std::cerr);
+         return 0;
+      }
+   }
+
+   // Индекс строится один раз по отсортированному пулу или берётся из снимка
+   std::optional<PrefixIndex> built{};
+   {
+      auto timer = stats.stage("index");
+      built.emplace(snapshot ? snapshot->index() : PrefixIndex{ipPool});
+   }
+   const PrefixIndex& index = *built;
+   const std::span<const IpAddress> pool{index.pool()};
+   stats.addresses = pool.size();
+
+   // Режим сервера: пул загружен и отсортирован один раз,
+   // далее только ответы на запросы
+   if (options.serve) {
+      if (options.path.empty() && options.snapshot.empty()
+         && options.socket.empty()) {
+         std::cerr << "--serve: запросы из stdin требуют файла с адресами\n";
+         return 1;
+      }
+      try {
+         auto timer = stats.stage("serve");
+         QueryServer server{index};
+         if (options.socket.empty()) {
+            server.serve(std::cin, std::cout);
+         }
+         else {
+            server.serveSocket(options.socket);
+         }
+      }
+      catch (const std::exception& e) {
+         std::cerr << e.what() << std::endl;
+         return 1;
+      }
+      stats.report(std::cerr);
+      return 0;
+   }
+
+   // Фильтрация по первому байту -- filter(1),
+   // по первому и второму байтам -- filter(46, 70).
+   // Подходящие адреса лежат в пуле подряд и находятся по индексу без просмотра
+   std::span<const IpAddress> firstByte{};
+   std::span<const IpAddress> firstTwoBytes{};
+   IndexList anyByte{};
+   {
+      auto timer = stats.stage("filter_first_byte");
+      firstByte = index.find(filter(1));
+   }
+   {
+      auto timer = stats.stage("filter_first_two_bytes");
+      firstTwoBytes = index.find(filter(46, 70));
+   }
+   // Фильтрация списка по любому байту, который равен 46,
+   // векторным ядром сразу по нескольку адресов
+   {
+      auto timer = stats.stage("filter_any_byte");
+      anyByte = filterAnyByte(pool, filter_any(46));
+   }
+
+   // Весь вывод идёт через общий буфер
+   IpWriter out{};
+   try {
+      auto timer = stats.stage("output");
+      // Отображаем отсортированный список ip-адресов,
+      // затем отфильтрованные списки в требуемом порядке
+      displayIP(out, pool);
+      displayIP(out, firstByte);
+      displayIP(out, firstTwoBytes);
+      displayIP(out, pool, anyByte);
+      out.flush();
+   }
+   catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+   }
+   stats.bytesWritten = out.bytesWritten();
+   stats.report(std::cerr);
+}
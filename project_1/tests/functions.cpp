@@ -5,6 +5,7 @@
 #include <ranges>
 #include <algorithm>
 #include <cctype>
+#include "../ip_filters.hpp" // Общий с main.cpp API фильтрации: filter, filter_any
 
 // Функция разбивает строку по разделителю
 // Здесь возвращаемое значение std::vector<std::string>
@@ -62,6 +63,8 @@ auto compareIP = [](const std::vector<std::string> &ip1,
    return false;
 };
 
+// Строковые варианты фильтров -- эталон для проверки filter(46, 70)
+// и filter_any(46) над упакованными адресами
 // Фильтрация по первому и второму байтам
 // Первый байт = 46, второй байт = 70
 auto filterOneTwo = [](const std::vector<std::string> &ip)
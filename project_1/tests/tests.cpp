@@ -1,5 +1,24 @@
 #include <gtest/gtest.h>
 #include "functions.cpp" // Импортируем наши функции и лямбды
+#include "../ip_address.hpp" // Упакованное представление ip-адреса
+#include "../ip_parser.hpp"  // Разбор текстовой записи ip-адреса
+#include "../ip_reader.hpp"  // Загрузка ip-адресов из файла
+#include "../ip_sort.hpp"    // Сортировка ip-адресов
+#include "../ip_filters.hpp" // Фильтрация пула ip-адресов
+#include "../ip_simd.hpp"    // Векторный фильтр по любому байту
+#include "../ip_index.hpp"   // Индекс префиксов
+#include "../ip_server.hpp"  // Сервер запросов
+#include "../ip_output.hpp"  // Буферизованный вывод
+#include "../ip_external.hpp" // Внешняя сортировка
+#include "../ip_aggregate.hpp" // Итоги по адресам
+#include "../ip_incremental.hpp" // Пополнение отсортированного пула
+#include "../ip_snapshot.hpp" // Двоичный снимок пула
+#include "../ip_stats.hpp"    // Отчёт --stats
+#include <cstdio>
+#include <sstream>
+#include <fstream>
+#include <random>
+#include <thread>
 
 
 
@@ -77,6 +96,78 @@ TEST(InvalidIPTest, SymbolThirdOctet)
    ASSERT_EQ(expected, actual);
 }
 
+// Тесты для функции parseIP: те же правила, что у invalidIP
+TEST(ParseIPTest, CorrectIP)
+{
+   std::optional<IpAddress> expected{IpAddress{192, 168, 1, 1}};
+   ASSERT_EQ(expected, parseIP("192.168.1.1"));
+   ASSERT_EQ(IpAddress(0, 0, 0, 0), parseIP("0.0.0.0"));
+   ASSERT_EQ(IpAddress(255, 255, 255, 255), parseIP("255.255.255.255"));
+}
+
+TEST(ParseIPTest, LeadingZeros)
+{
+   // std::stoi в invalidIP допускает ведущие нули
+   ASSERT_EQ(IpAddress(1, 2, 3, 4), parseIP("001.002.003.004"));
+   ASSERT_EQ(IpAddress(255, 1, 1, 1), parseIP("0000255.1.1.1"));
+   ASSERT_EQ(IpAddress(1, 2, 3, 4), parseIP("0001.2.3.4"));
+}
+
+TEST(ParseIPTest, IncorrectOctetCount)
+{
+   ASSERT_FALSE(parseIP("192.168.1").has_value());
+   ASSERT_FALSE(parseIP("192.168.1.1.1").has_value());
+   ASSERT_FALSE(parseIP("").has_value());
+}
+
+TEST(ParseIPTest, EmptyOctet)
+{
+   ASSERT_FALSE(parseIP("85.254..10").has_value());
+   ASSERT_FALSE(parseIP(".179.210.145").has_value());
+   ASSERT_FALSE(parseIP("79.180.73.").has_value());
+}
+
+TEST(ParseIPTest, OutOfRangeOctet)
+{
+   ASSERT_FALSE(parseIP("192.168.1.256").has_value());
+   ASSERT_FALSE(parseIP("999.168.1.1").has_value());
+   ASSERT_FALSE(parseIP("1.2.3.99999999999999").has_value());
+}
+
+TEST(ParseIPTest, NonDigitOctet)
+{
+   ASSERT_FALSE(parseIP("-1.168.1.240").has_value());
+   ASSERT_FALSE(parseIP("192.f.1.245").has_value());
+   ASSERT_FALSE(parseIP("192.168.*.245").has_value());
+   ASSERT_FALSE(parseIP("1.2.3.4 ").has_value());
+   ASSERT_FALSE(parseIP("1.2.3.\xb4").has_value());
+}
+
+TEST(ParseIPTest, SameAsInvalidIP)
+{
+   // Случайные строки из цифр, точек и посторонних символов
+   std::mt19937 engine{2024};
+   const std::string alphabet{"0123456789....-a\xb0"};
+   for (int i{}; i < 200000; ++i) {
+      std::string text(engine() % 19, ' ');
+      for (char& ch : text) ch = alphabet[engine() % alphabet.size()];
+      auto octets = split(text, '.');
+      bool invalid{};
+      try {
+         invalid = invalidIP(octets);
+      }
+      catch (const std::exception&) {
+         invalid = true; // std::stoi не смог разобрать октет
+      }
+      auto parsed = parseIP(text);
+      ASSERT_EQ(invalid, !parsed.has_value()) << text;
+      if (parsed) {
+         ASSERT_EQ(makeIP(octets), *parsed) << text;
+      }
+      ASSERT_EQ(parseIPScalar(text), parsed) << text;
+   }
+}
+
 // Тесты для функции compareIP
 TEST(CompareIPTest, ReverseLexicographicSort_1)
 {
@@ -139,6 +230,727 @@ TEST(AnyByteFilterTest, NoMatchingByte)
    ASSERT_EQ(expected, actual);
 }
 
+// Тесты для упакованного ip-адреса IpAddress
+TEST(IpAddressTest, OctetAccess)
+{
+   IpAddress ip{192, 168, 1, 2};
+   std::array<std::uint8_t, 4> expected{192, 168, 1, 2};
+   ASSERT_EQ(expected, ip.octets());
+   ASSERT_EQ(0xC0A80102u, ip.value()); // старший байт -- первый октет
+}
+
+TEST(IpAddressTest, ToString)
+{
+   IpAddress ip{0, 10, 100, 255};
+   std::string expected{"0.10.100.255"};
+   ASSERT_EQ(expected, ip.toString());
+}
+
+TEST(IpAddressTest, MakeFromOctets)
+{
+   std::vector<std::string> octets{"46", "70", "225", "39"};
+   IpAddress expected{46, 70, 225, 39};
+   ASSERT_EQ(expected, makeIP(octets));
+}
+
+TEST(IpAddressTest, NumericNotStringOrder)
+{
+   IpAddress ip1{1, 10, 1, 1};
+   IpAddress ip2{1, 2, 1, 1};
+   bool expected{true}; // 1.10.1.1 > 1.2.1.1, т.к. 10 > 2
+   bool actual{ip1 > ip2};
+   ASSERT_EQ(expected, actual);
+}
+
+// Тесты параллельного разбора: порядок и состав адресов
+// совпадают с последовательным разбором при любом числе потоков
+TEST(ParallelParseTest, SameAsSerial)
+{
+   MappedFile file{"../ip_filter.tsv"};
+   std::vector<IpAddress> expected{};
+   parseBuffer(file.data(), expected);
+   ASSERT_EQ(1000u, expected.size());
+   for (unsigned threads : {1u, 2u, 3u, 8u, 32u, 2000u}) {
+      ASSERT_EQ(expected, parseBufferParallel(file.data(), threads));
+   }
+}
+
+TEST(ParallelParseTest, InvalidLinesSkipped)
+{
+   MappedFile file{"../ip_filter_test.tsv"};
+   std::vector<IpAddress> expected{
+      {157, 39, 22, 224}, {219, 102, 120, 135}, {67, 232, 81, 208},
+      {23, 240, 215, 189}, {185, 69, 186, 168}};
+   ASSERT_EQ(expected, parseBufferParallel(file.data(), 4));
+}
+
+TEST(ParallelParseTest, RejectsNonRegularFile)
+{
+   // У FIFO нулевой размер: без проверки он читался бы как пустой файл
+   const std::string path{::testing::TempDir() + "ip_reader_test.fifo"};
+   std::remove(path.c_str());
+   ASSERT_EQ(0, ::mkfifo(path.c_str(), 0600));
+   ASSERT_FALSE(isRegularFile(path));
+   EXPECT_THROW(MappedFile{path}, std::system_error);
+   std::remove(path.c_str());
+   ASSERT_TRUE(isRegularFile("../ip_filter.tsv"));
+}
+
+TEST(ParallelParseTest, ThreadCountValidated)
+{
+   ASSERT_EQ(1u, parseThreadCount("1"));
+   ASSERT_EQ(maxThreadsPerCore, parseThreadCount(std::to_string(maxThreadsPerCore)));
+   for (const char* text : {"", "0", "-1", "+2", " 2", "2x", "x"}) {
+      ASSERT_THROW(parseThreadCount(text), std::invalid_argument) << text;
+   }
+   ASSERT_THROW(parseThreadCount("4294967295"), std::out_of_range);
+   ASSERT_THROW(parseThreadCount("99999999999"), std::out_of_range);
+}
+
+// Тесты поразрядной сортировки
+TEST(RadixSortTest, SameAsComparisonSort)
+{
+   MappedFile file{"../ip_filter.tsv"};
+   std::vector<IpAddress> expected{};
+   parseBuffer(file.data(), expected);
+   std::vector<IpAddress> actual{expected};
+   sortIP(expected, SortEngine::comparison);
+   sortIP(actual, SortEngine::radix);
+   ASSERT_EQ(expected, actual);
+}
+
+TEST(RadixSortTest, StableForDuplicates)
+{
+   // Второй элемент пары -- позиция во входных данных
+   std::vector<std::pair<IpAddress, int>> input{
+      {{185, 46, 86, 131}, 0}, {{1, 2, 3, 4}, 1}, {{185, 46, 86, 131}, 2},
+      {{1, 10, 1, 1}, 3}, {{185, 46, 86, 131}, 4}, {{1, 2, 3, 4}, 5}};
+   std::vector<std::pair<IpAddress, int>> expected{
+      {{185, 46, 86, 131}, 0}, {{185, 46, 86, 131}, 2},
+      {{185, 46, 86, 131}, 4}, {{1, 10, 1, 1}, 3}, {{1, 2, 3, 4}, 1},
+      {{1, 2, 3, 4}, 5}};
+   radixSortDescending(input,
+      [](const std::pair<IpAddress, int>& item){ return item.first.value(); });
+   ASSERT_EQ(expected, input);
+}
+
+TEST(RadixSortTest, ParallelSameAsSerial)
+{
+   // Пары "адрес -- позиция во входных данных" проверяют и устойчивость
+   std::mt19937 engine{11};
+   std::vector<std::pair<IpAddress, std::size_t>> expected(300000);
+   for (std::size_t i{}; i < expected.size(); ++i) {
+      // Немного различных адресов -- много повторов, неравные корзины
+      std::uint32_t value{static_cast<std::uint32_t>(engine() % 4 == 0
+         ? 0x2E460000u | (engine() % 1024) : engine() % 100000 << 8)};
+      expected[i] = {IpAddress{value}, i};
+   }
+   auto key = [](const std::pair<IpAddress, std::size_t>& item) {
+      return item.first.value();
+   };
+   auto input = expected;
+   radixSortDescending(expected, key);
+   for (unsigned threads : {1u, 2u, 3u, 8u}) {
+      auto actual = input;
+      radixSortDescendingParallel(actual, threads, key);
+      ASSERT_EQ(expected, actual);
+   }
+}
+
+// Тесты векторного фильтра по любому байту.
+// Результат сравнивается со строковым фильтром anyByteFilter
+TEST(FilterAnyByteTest, SameAsAnyByteFilter)
+{
+   std::ifstream input{"../ip_filter.tsv"};
+   ASSERT_TRUE(input.is_open());
+   std::vector<std::vector<std::string>> stringPool{};
+   for (std::string line; std::getline(input, line);) {
+      auto octets = split(split(line, '\t').at(0), '.');
+      if (!invalidIP(octets)) stringPool.push_back(octets);
+   }
+   std::vector<IpAddress> pool{};
+   IndexList expected{};
+   for (std::size_t i{}; i < stringPool.size(); ++i) {
+      pool.push_back(makeIP(stringPool[i]));
+      if (anyByteFilter(stringPool[i])) expected.push_back(i);
+   }
+   ASSERT_FALSE(expected.empty());
+
+   std::vector<SimdLevel> levels{SimdLevel::scalar};
+   if (detectSimdLevel() != SimdLevel::scalar) levels.push_back(SimdLevel::sse2);
+   if (detectSimdLevel() == SimdLevel::avx2) levels.push_back(SimdLevel::avx2);
+   for (SimdLevel level : levels) {
+      ASSERT_EQ(expected, filterAnyByte(pool, 46, level));
+   }
+}
+
+TEST(FilterAnyByteTest, AllPositionsAndTail)
+{
+   // 11 адресов: не кратно ширине регистра, байт 46 на каждой позиции
+   std::vector<IpAddress> pool{
+      {46, 0, 0, 0}, {0, 46, 0, 0}, {0, 0, 46, 0}, {0, 0, 0, 46},
+      {45, 47, 146, 0}, {46, 46, 46, 46}, {1, 2, 3, 4}, {255, 255, 255, 255},
+      {0, 0, 0, 0}, {7, 8, 9, 10}, {1, 1, 1, 46}};
+   IndexList expected{0, 1, 2, 3, 5, 10};
+   for (SimdLevel level : {SimdLevel::scalar, detectSimdLevel()}) {
+      ASSERT_EQ(expected, filterAnyByte(pool, 46, level));
+   }
+   ASSERT_EQ((IndexList{0, 1, 2, 3, 4, 8}), filterAnyByte(pool, 0));
+}
+
+// Тесты обобщённых фильтров filter(...) и filter_any(...)
+TEST(FilterTest, FirstByte)
+{
+   static_assert(filter(1)(IpAddress{1, 2, 3, 4}));
+   ASSERT_TRUE(filter(1)(IpAddress{1, 255, 0, 0}));
+   ASSERT_FALSE(filter(1)(IpAddress{10, 1, 1, 1}));
+   ASSERT_FALSE(filter(1)(IpAddress{0, 1, 1, 1}));
+}
+
+TEST(FilterTest, FirstAndSecondBytes)
+{
+   ASSERT_TRUE(filter(46, 70)(IpAddress{46, 70, 225, 39}));
+   ASSERT_FALSE(filter(46, 70)(IpAddress{46, 71, 225, 39}));
+   ASSERT_FALSE(filter(46, 70)(IpAddress{70, 46, 225, 39}));
+   ASSERT_EQ(0xFFFF0000u, decltype(filter(46, 70))::mask);
+}
+
+TEST(FilterTest, AllOctets)
+{
+   ASSERT_TRUE(filter(192, 168, 1, 1)(IpAddress{192, 168, 1, 1}));
+   ASSERT_FALSE(filter(192, 168, 1, 1)(IpAddress{192, 168, 1, 2}));
+}
+
+TEST(FilterTest, AnyByte)
+{
+   ASSERT_TRUE(filter_any(46)(IpAddress{192, 46, 1, 1}));
+   ASSERT_TRUE(filter_any(0)(IpAddress{192, 168, 0, 1}));
+   ASSERT_FALSE(filter_any(46)(IpAddress{192, 168, 1, 1}));
+   ASSERT_FALSE(filter_any(46)(IpAddress{47, 45, 146, 174}));
+}
+
+TEST(FilterTest, OctetOutOfRange)
+{
+   ASSERT_THROW(filter(256), std::out_of_range);
+   ASSERT_THROW(filter(46, -1), std::out_of_range);
+   ASSERT_THROW(filter_any(300), std::out_of_range);
+   ASSERT_NO_THROW(filter(255, 0));
+}
+
+TEST(FilterTest, SameAsStringFilters)
+{
+   // Перебираем все значения каждого октета по очереди
+   for (int value{}; value < 256; ++value) {
+      for (std::size_t position{}; position < 4; ++position) {
+         std::array<std::uint8_t, 4> octets{46, 70, 1, 1};
+         octets[position] = static_cast<std::uint8_t>(value);
+         IpAddress ip{octets[0], octets[1], octets[2], octets[3]};
+         std::vector<std::string> strings{};
+         for (auto octet : octets) strings.push_back(std::to_string(octet));
+         ASSERT_EQ(filterOneTwo(strings), filter(46, 70)(ip));
+         ASSERT_EQ(anyByteFilter(strings), filter_any(46)(ip));
+      }
+   }
+}
+
+// Тесты индекса префиксов: результат совпадает с линейным просмотром
+class PrefixIndexTest : public ::testing::Test
+{
+protected:
+   void SetUp() override
+   {
+      MappedFile file{"../ip_filter.tsv"};
+      parseBuffer(file.data(), pool);
+      sortIP(pool);
+   }
+
+   template<typename Predicate>
+   std::vector<IpAddress> scan(Predicate predicate) const
+   {
+      std::vector<IpAddress> result{};
+      std::ranges::copy_if(pool, std::back_inserter(result), predicate);
+      return result;
+   }
+
+   static std::vector<IpAddress> toVector(std::span<const IpAddress> view)
+   {
+      return {view.begin(), view.end()};
+   }
+
+   std::vector<IpAddress> pool{};
+};
+
+TEST_F(PrefixIndexTest, FirstOctet)
+{
+   PrefixIndex index{pool};
+   for (int octet{}; octet < 256; ++octet) {
+      auto prefix = filter(octet);
+      ASSERT_EQ(scan(prefix), toVector(index.find(prefix)));
+   }
+}
+
+TEST_F(PrefixIndexTest, TwoAndThreeOctets)
+{
+   PrefixIndex index{pool};
+   ASSERT_EQ(4u, index.find(filter(46, 70)).size());
+   ASSERT_EQ(scan(filter(46, 70)), toVector(index.find(filter(46, 70))));
+   ASSERT_EQ(scan(filter(185, 46, 86)), toVector(index.find(filter(185, 46, 86))));
+   ASSERT_EQ(scan(filter(185, 46, 86, 131)),
+      toVector(index.find(filter(185, 46, 86, 131))));
+   ASSERT_TRUE(index.find(filter(46, 69)).empty());
+}
+
+TEST_F(PrefixIndexTest, Cidr)
+{
+   PrefixIndex index{pool};
+   auto block = parseCidr("46.70.0.0/16");
+   ASSERT_TRUE(block.has_value());
+   ASSERT_EQ(scan(filter(46, 70)), toVector(index.find(*block)));
+   auto wide = parseCidr("46.0.0.0/9");
+   ASSERT_TRUE(wide.has_value());
+   ASSERT_EQ(scan([](IpAddress ip){ return ip.octet(0) == 46 && ip.octet(1) < 128; }),
+      toVector(index.find(*wide)));
+   ASSERT_EQ(pool.size(), index.find(*parseCidr("0.0.0.0/0")).size());
+   ASSERT_FALSE(parseCidr("46.70.0.0/33").has_value());
+   ASSERT_FALSE(parseCidr("46.70.0.0").has_value());
+}
+
+TEST_F(PrefixIndexTest, Range)
+{
+   PrefixIndex index{pool};
+   IpAddress low{39, 0, 0, 0};
+   IpAddress high{68, 46, 218, 208};
+   ASSERT_EQ(scan([&](IpAddress ip){ return low <= ip && ip <= high; }),
+      toVector(index.range(low, high)));
+   ASSERT_TRUE(index.range(high, low).empty());
+}
+
+// Тесты сервера запросов
+TEST(QueryServerTest, Queries)
+{
+   std::vector<IpAddress> pool{
+      {46, 70, 225, 39}, {1, 2, 3, 4}, {46, 70, 29, 76}, {5, 189, 203, 46},
+      {1, 10, 1, 1}};
+   sortIP(pool);
+   QueryServer server{pool};
+   std::istringstream input{
+      "prefix 46.70\nany 46\ncidr 1.0.0.0/8\nrange 1.5.0.0 5.189.203.46\n"
+      "prefix 1.2.3.4.5\nunknown 1\n"};
+   std::ostringstream output{};
+   server.serve(input, output);
+
+   std::vector<std::string> lines{};
+   std::istringstream result{output.str()};
+   for (std::string line; std::getline(result, line);) {
+      // Время ответа меняется от запуска к запуску, но есть в каждой
+      // строке состояния
+      if (line.starts_with("OK") || line.starts_with("ERR")) {
+         EXPECT_NE(std::string::npos, line.find(" time_us="));
+      }
+      lines.push_back(line.substr(0, line.find(" time_us=")));
+   }
+   std::vector<std::string> expected{
+      "46.70.225.39", "46.70.29.76", "OK count=2",
+      "46.70.225.39", "46.70.29.76", "5.189.203.46", "OK count=3",
+      "1.10.1.1", "1.2.3.4", "OK count=2",
+      "5.189.203.46", "1.10.1.1", "OK count=2",
+      "ERR неверный префикс",
+      "ERR неизвестный запрос"};
+   ASSERT_EQ(expected, lines);
+}
+
+TEST(QueryServerTest, SocketKeepsRegularFile)
+{
+   const std::string path{::testing::TempDir() + "ip_server_not_socket"};
+   std::ofstream{path} << "данные\n";
+   std::vector<IpAddress> pool{{1, 2, 3, 4}};
+   QueryServer server{pool};
+   ASSERT_THROW(server.serveSocket(path), std::system_error);
+   std::ifstream kept{path};
+   std::string line{};
+   ASSERT_TRUE(std::getline(kept, line));
+   ASSERT_EQ("данные", line);
+   std::remove(path.c_str());
+}
+
+TEST(QueryServerTest, SocketDropsLongQuery)
+{
+   const std::string path{::testing::TempDir() + "ip_server_long.sock"};
+   std::vector<IpAddress> pool{{1, 2, 3, 4}};
+   QueryServer server{pool};
+   std::jthread serverThread{[&server, &path] { server.serveSocket(path); }};
+
+   // Запрос клиента и ответ до закрытия соединения сервером
+   auto request = [&path](const std::string& data) {
+      sockaddr_un address{};
+      address.sun_family = AF_UNIX;
+      path.copy(address.sun_path, path.size());
+      int client{::socket(AF_UNIX, SOCK_STREAM, 0)};
+      while (::connect(client, reinterpret_cast<sockaddr*>(&address),
+            sizeof(address)) == -1) {
+         std::this_thread::sleep_for(std::chrono::milliseconds{1});
+      }
+      ::send(client, data.data(), data.size(), MSG_NOSIGNAL);
+      ::shutdown(client, SHUT_WR);
+      std::string reply{};
+      char buffer[256];
+      for (ssize_t size; (size = ::recv(client, buffer, sizeof(buffer), 0)) > 0;) {
+         reply.append(buffer, static_cast<std::size_t>(size));
+      }
+      ::close(client);
+      return reply;
+   };
+   // Время ответа меняется от запуска к запуску
+   auto status = [](const std::string& reply) {
+      return reply.substr(0, reply.find(" time_us="));
+   };
+   std::string longQuery(QueryServer::maxQueryLength + 100, 'x');
+   std::string reply{request(longQuery)};
+   ASSERT_EQ("ERR слишком длинный запрос", status(reply));
+   ASSERT_EQ('\n', reply.back());
+   ASSERT_EQ("ERR слишком длинный запрос", status(request(longQuery + "\n")));
+   ASSERT_EQ("OK count=0", status(request("shutdown\n")));
+}
+
+// Тесты буферизованного вывода
+TEST(OutputTest, FormatAllOctets)
+{
+   char line[maxLineLength];
+   for (int value{}; value < 256; ++value) {
+      auto octet = static_cast<std::uint8_t>(value);
+      for (IpAddress ip : {IpAddress{octet, 0, 0, 0}, IpAddress{0, 0, 0, octet},
+            IpAddress{octet, octet, octet, octet}}) {
+         ASSERT_EQ(ip.toString() + '\n', std::string(line, formatIP(ip, line)));
+      }
+   }
+}
+
+TEST(OutputTest, WriterExactBytes)
+{
+   std::FILE* file{std::tmpfile()};
+   ASSERT_NE(nullptr, file);
+   std::vector<IpAddress> pool{
+      {255, 255, 255, 255}, {46, 70, 1, 0}, {1, 2, 3, 4}, {0, 0, 0, 0}};
+   std::string expected{};
+   {
+      // Маленький буфер, чтобы проверить сброс посреди вывода
+      IpWriter out{fileno(file), 20};
+      for (int i{}; i < 10; ++i) {
+         out.write(pool);
+         for (IpAddress ip : pool) expected += ip.toString() + '\n';
+      }
+      out.write(std::string_view{"end\n"});
+      expected += "end\n";
+      ASSERT_EQ(expected.size(), out.bytesWritten());
+   }
+   std::string actual(expected.size() + 1, '\0');
+   std::rewind(file);
+   actual.resize(std::fread(actual.data(), 1, actual.size(), file));
+   std::fclose(file);
+   ASSERT_EQ(expected, actual);
+   ASSERT_EQ(std::string::npos, actual.find('\b'));
+}
+
+// Тесты внешней сортировки: порядок совпадает с сортировкой в памяти
+TEST(ExternalSortTest, ManyRuns)
+{
+   std::mt19937 engine{7};
+   std::vector<IpAddress> expected(20000);
+   for (auto& ip : expected) ip = IpAddress{static_cast<std::uint32_t>(engine() % 5000)};
+   // На 4096 байт хватает буферов только для слияния двух серий
+   ExternalSorter sorter{4096};
+   ASSERT_EQ(2u, sorter.fanIn());
+   for (IpAddress ip : expected) sorter.add(ip);
+   ASSERT_LT(sorter.runs(), sorter.fanIn());
+   std::vector<IpAddress> actual{};
+   sorter.merge([&](IpAddress ip) { actual.push_back(ip); });
+   sortIP(expected);
+   ASSERT_EQ(expected, actual);
+}
+
+TEST(ExternalSortTest, MoreRunsThanFanIn)
+{
+   std::mt19937 engine{11};
+   std::vector<IpAddress> expected(200000);
+   for (auto& ip : expected) ip = IpAddress{static_cast<std::uint32_t>(engine())};
+   ExternalSorter sorter{16384, 4};
+   ASSERT_EQ(4u, sorter.fanIn());
+   for (IpAddress ip : expected) sorter.add(ip);
+   // Порций много больше, чем сливается за раз, а открыто меньше fanIn серий
+   ASSERT_GT(sorter.spills(), 4 * sorter.fanIn());
+   ASSERT_LT(sorter.runs(), sorter.fanIn());
+   std::vector<IpAddress> actual{};
+   sorter.merge([&](IpAddress ip) { actual.push_back(ip); });
+   sortIP(expected);
+   ASSERT_EQ(expected, actual);
+}
+
+TEST(ExternalSortTest, TooSmallLimit)
+{
+   ASSERT_THROW(ExternalSorter{1024}, std::invalid_argument);
+   ASSERT_THROW((ExternalSorter{1 << 20, 1}), std::invalid_argument);
+}
+
+TEST(ExternalSortTest, FitsInMemory)
+{
+   std::vector<IpAddress> expected{{1, 2, 3, 4}, {46, 70, 0, 1}, {1, 10, 1, 1}};
+   ExternalSorter sorter{1 << 20};
+   for (IpAddress ip : expected) sorter.add(ip);
+   std::vector<IpAddress> actual{};
+   sorter.merge([&](IpAddress ip) { actual.push_back(ip); });
+   ASSERT_EQ(0u, sorter.runs());
+   sortIP(expected);
+   ASSERT_EQ(expected, actual);
+}
+
+TEST(ExternalSortTest, MemoryLimitSuffixes)
+{
+   ASSERT_EQ(4096u, parseMemoryLimit("4096"));
+   ASSERT_EQ(4096u, parseMemoryLimit("4K"));
+   ASSERT_EQ(std::size_t{64} << 20, parseMemoryLimit("64M"));
+   ASSERT_EQ(std::size_t{2} << 30, parseMemoryLimit("2G"));
+   ASSERT_THROW(parseMemoryLimit("5X"), std::invalid_argument);
+   ASSERT_THROW(parseMemoryLimit("-1"), std::invalid_argument);
+   ASSERT_THROW(parseMemoryLimit(" 1"), std::invalid_argument);
+   ASSERT_THROW(parseMemoryLimit("17179869184G"), std::out_of_range);
+}
+
+// Тесты свёртки повторов и суммирования столбцов
+TEST(AggregateTest, CollapseDuplicates)
+{
+   AddressColumns columns{};
+   parseColumns("1.2.3.4\t5\t6\n"
+      "bad\t1\t1\n"
+      "46.70.0.1\t10\t0\n"
+      "1.2.3.4\t7\t1\r\n"
+      "1.10.1.1\tx\n", columns);
+   ASSERT_EQ(4u, columns.size());
+   AddressTotals totals{aggregate(columns)};
+   std::vector<IpAddress> addresses{{46, 70, 0, 1}, {1, 10, 1, 1}, {1, 2, 3, 4}};
+   ASSERT_EQ(addresses, totals.addresses);
+   ASSERT_EQ((std::vector<std::uint64_t>{1, 1, 2}), totals.counts);
+   ASSERT_EQ((std::vector<std::uint64_t>{10, 0, 12}), totals.text2);
+   ASSERT_EQ((std::vector<std::uint64_t>{0, 0, 7}), totals.text3);
+}
+
+TEST(AggregateTest, IndexedSameAsPacked)
+{
+   // Путь для 2^32 строк и больше проверяется на обычном объёме
+   AddressColumns columns{loadColumns("../ip_filter.tsv")};
+   AddressTotals packed{aggregate(columns, 2)};
+   AddressTotals indexed{detail::aggregateIndexed(columns, 2)};
+   ASSERT_EQ(packed.addresses, indexed.addresses);
+   ASSERT_EQ(packed.counts, indexed.counts);
+   ASSERT_EQ(packed.text2, indexed.text2);
+   ASSERT_EQ(packed.text3, indexed.text3);
+}
+
+TEST(AggregateTest, WriteTotals)
+{
+   AddressColumns columns{loadColumns("../ip_filter.tsv")};
+   AddressTotals totals{aggregate(columns, 4)};
+   std::uint64_t lines{};
+   for (std::uint64_t count : totals.counts) lines += count;
+   ASSERT_EQ(columns.size(), lines);
+   ASSERT_TRUE(std::ranges::is_sorted(totals.addresses, std::ranges::greater{}));
+   ASSERT_EQ(totals.addresses.end(), std::ranges::adjacent_find(totals.addresses));
+
+   std::FILE* file{std::tmpfile()};
+   ASSERT_NE(nullptr, file);
+   {
+      IpWriter out{fileno(file)};
+      writeTotals(out, totals);
+   }
+   std::string text(1 << 20, '\0');
+   std::rewind(file);
+   text.resize(std::fread(text.data(), 1, text.size(), file));
+   std::fclose(file);
+   ASSERT_NE(std::string::npos, text.find("\n185.46.86.131\t2\t4\t0\n"));
+}
+
+// Тесты пополнения пула: результат совпадает с полной сортировкой
+TEST(IncrementalTest, AppendInParts)
+{
+   std::vector<IpAddress> all{loadFile("../ip_filter.tsv")};
+   IncrementalPool pool{};
+   // Порции разного размера, включая пустую
+   std::size_t bounds[]{0, 1, 1, 300, 700, all.size()};
+   for (std::size_t i{1}; i < std::size(bounds); ++i) {
+      pool.append({all.begin() + static_cast<std::ptrdiff_t>(bounds[i - 1]),
+         all.begin() + static_cast<std::ptrdiff_t>(bounds[i])});
+   }
+   sortIP(all);
+   ASSERT_TRUE(std::ranges::equal(all, pool.pool()));
+   const PrefixIndex index{all};
+   ASSERT_TRUE(std::ranges::equal(index.find(filter(1)), pool.find(filter(1))));
+   ASSERT_TRUE(std::ranges::equal(index.find(filter(46, 70)),
+      pool.find(filter(46, 70))));
+   std::vector<IpAddress> anyByte{};
+   std::ranges::copy_if(all, std::back_inserter(anyByte), filter_any(46));
+   ASSERT_TRUE(std::ranges::equal(anyByte, pool.anyByte()));
+}
+
+// Временный файл в каталоге тестов. Удаляется и при провале проверки:
+// ASSERT_* выходит из теста, не доходя до std::remove в его конце
+struct TempFile {
+   const std::string path;
+
+   explicit TempFile(const std::string& name)
+      : path{::testing::TempDir() + name} {
+         std::remove(path.c_str());
+   }
+
+   ~TempFile() {
+      std::remove(path.c_str());
+   }
+};
+
+TEST(IncrementalTest, SaveAndLoad)
+{
+   const TempFile temp{"ip_incremental_test.bin"};
+   const std::string& path{temp.path};
+   ASSERT_TRUE(IncrementalPool::load(path).pool().empty());
+   IncrementalPool pool{};
+   pool.append({{1, 2, 3, 4}, {46, 70, 0, 1}});
+   pool.save(path);
+   IncrementalPool loaded{IncrementalPool::load(path)};
+   loaded.append({{46, 1, 1, 1}, {1, 10, 1, 1}});
+   std::vector<IpAddress> expected{
+      {46, 70, 0, 1}, {46, 1, 1, 1}, {1, 10, 1, 1}, {1, 2, 3, 4}};
+   ASSERT_TRUE(std::ranges::equal(expected, loaded.pool()));
+   ASSERT_EQ(2u, loaded.anyByte().size());
+   ASSERT_EQ(2u, loaded.find(filter(1)).size());
+}
+
+TEST(IncrementalTest, RejectCorrupted)
+{
+   const TempFile temp{"ip_incremental_test.bin"};
+   const std::string& path{temp.path};
+   IncrementalPool pool{};
+   pool.append({{1, 2, 3, 4}, {46, 70, 0, 1}});
+   pool.save(path);
+   // Порча размера пула: файл отвергается до выделения памяти
+   auto patch = [&path](long offset, std::uint64_t value) {
+      std::FILE* file{std::fopen(path.c_str(), "r+b")};
+      std::fseek(file, offset, SEEK_SET);
+      std::fwrite(&value, sizeof(value), 1, file);
+      std::fclose(file);
+   };
+   patch(offsetof(IncrementalHeader, poolSize), std::uint64_t{1} << 60);
+   ASSERT_THROW(IncrementalPool::load(path), std::runtime_error);
+   // Порча адресов обнаруживает контрольная сумма
+   pool.save(path);
+   patch(sizeof(IncrementalHeader), 0);
+   ASSERT_THROW(IncrementalPool::load(path), std::runtime_error);
+   ASSERT_THROW(IncrementalPool::load("../ip_filter.tsv"), std::runtime_error);
+}
+
+// Тесты снимка пула: после открытия тот же пул и тот же индекс
+TEST(SnapshotTest, WriteAndOpen)
+{
+   const TempFile temp{"ip_snapshot_test.snap"};
+   const std::string& path{temp.path};
+   std::vector<IpAddress> pool{loadFile("../ip_filter.tsv")};
+   sortIP(pool);
+   writeSnapshot(path, pool);
+   {
+      Snapshot snapshot{path, true};
+      ASSERT_TRUE(std::ranges::equal(pool, snapshot.pool()));
+      const PrefixIndex index{pool};
+      ASSERT_EQ(index.offsets(), snapshot.index().offsets());
+      ASSERT_TRUE(std::ranges::equal(index.find(filter(46, 70)),
+         snapshot.index().find(filter(46, 70))));
+   }
+}
+
+TEST(SnapshotTest, RejectCorrupted)
+{
+   const TempFile temp{"ip_snapshot_test.snap"};
+   const std::string& path{temp.path};
+   writeSnapshot(path, std::vector<IpAddress>{{46, 70, 0, 1}, {1, 2, 3, 4}});
+   // Порча одного байта в адресах и в заголовке
+   auto corrupt = [&path](long offset) {
+      std::FILE* file{std::fopen(path.c_str(), "r+b")};
+      std::fseek(file, offset, SEEK_SET);
+      int byte{std::fgetc(file)};
+      std::fseek(file, offset, SEEK_SET);
+      std::fputc(byte ^ 1, file);
+      std::fclose(file);
+   };
+   corrupt(sizeof(SnapshotHeader) + 1);
+   ASSERT_NO_THROW(Snapshot(path, false));
+   ASSERT_THROW(Snapshot(path, true), std::runtime_error);
+   corrupt(offsetof(SnapshotHeader, count));
+   ASSERT_THROW(Snapshot(path, false), std::runtime_error);
+   ASSERT_THROW(Snapshot("../ip_filter.tsv"), std::runtime_error);
+}
+
+// Тесты отчёта --stats
+TEST(StatsTest, DisabledReportsNothing)
+{
+   Stats stats{};
+   {
+      auto timer = stats.stage("sort");
+   }
+   std::ostringstream output{};
+   stats.report(output);
+   ASSERT_TRUE(output.str().empty());
+}
+
+TEST(StatsTest, ReportStagesAndCounters)
+{
+   Stats stats{true};
+   {
+      auto timer = stats.stage("parse");
+      std::vector<IpAddress> pool{loadFile("../ip_filter.tsv", 1, &stats.input)};
+      stats.addresses = pool.size();
+   }
+   {
+      auto timer = stats.stage("sort");
+   }
+   std::ostringstream output{};
+   stats.report(output);
+   const std::string json{output.str()};
+   ASSERT_EQ(0u, json.find("{\"stages_ms\":{\"parse\":"));
+   ASSERT_NE(std::string::npos, json.find(",\"sort\":"));
+   ASSERT_NE(std::string::npos, json.find("\"lines_read\":1000,"));
+   ASSERT_NE(std::string::npos, json.find("\"lines_rejected\":0,"));
+   ASSERT_NE(std::string::npos, json.find("\"peak_rss_kb\":"));
+   ASSERT_EQ("}\n", json.substr(json.size() - 2));
+}
+
+TEST(StatsTest, BlankLinesNotRejected)
+{
+   const std::string text{"1.2.3.4\tx\n\n  \r\n1..2.3\n46.70.1.1\n"};
+   const std::string path{::testing::TempDir() + "ip_stats_test.tsv"};
+   {
+      std::ofstream file{path};
+      file << text;
+   }
+   InputStats mapped{};
+   std::vector<IpAddress> pool{loadFile(path, 2, &mapped)};
+   std::remove(path.c_str());
+   ASSERT_EQ(2u, pool.size());
+   ASSERT_EQ(5u, mapped.lines);
+   ASSERT_EQ(1u, mapped.rejected);
+   InputStats streamed{};
+   std::istringstream input{text};
+   for (std::string line; std::getline(input, line);) {
+      countLine(streamed, line, parseIP(firstField(line)).has_value());
+   }
+   ASSERT_EQ(5u, streamed.lines);
+   ASSERT_EQ(1u, streamed.rejected);
+   ASSERT_EQ(text.size(), streamed.bytes);
+}
+
+TEST(StatsTest, CountLines)
+{
+   ASSERT_EQ(0u, countLines(""));
+   ASSERT_EQ(1u, countLines("1.2.3.4"));
+   ASSERT_EQ(2u, countLines("1.2.3.4\n\n"));
+   ASSERT_EQ(2u, countLines("1.2.3.4\nx"));
+}
+
 // Главная точка входа для запуска тестов
 int main(int argc, char **argv)
 {
@@ -0,0 +1,91 @@
+// alloc_stats.hpp -- политики сбора статистики аллокаторов
+
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+// Политика без статистики: пустые встраиваемые функции, а в аллокаторе
+// пустой член с [[no_unique_address]], поэтому ни места, ни времени
+// политика не занимает
+struct NoStats {
+   static constexpr bool enabled{false};
+
+   void block(std::size_t) noexcept {}
+   void allocated(std::size_t) noexcept {}
+   void deallocated(std::size_t) noexcept {}
+   void failed() noexcept {}
+   void released() noexcept {}
+};
+
+// Статистика одного пула: по ней подбирается ёмкость пула под реальную
+// нагрузку. Пиковый объём peakBytes -- нижняя граница ёмкости, разница
+// reservedBytes и peakBytes -- память, которая так и не понадобилась
+struct AllocStats {
+   static constexpr bool enabled{true};
+
+   std::size_t allocations{};   // Вызовов allocate
+   std::size_t deallocations{}; // Вызовов deallocate
+   std::size_t failures{};      // Отказов в выделении
+   std::size_t bytesInUse{};    // Выдано и не возвращено байт
+   std::size_t peakBytes{};     // Наибольшее значение bytesInUse
+   std::size_t blocks{};        // Выделено блоков
+   std::size_t reservedBytes{}; // Объём всех блоков
+
+   void block(std::size_t bytes) noexcept {
+      ++blocks;
+      reservedBytes += bytes;
+   }
+
+   void allocated(std::size_t bytes) noexcept {
+      ++allocations;
+      bytesInUse += bytes;
+      if (bytesInUse > peakBytes) peakBytes = bytesInUse;
+   }
+
+   void deallocated(std::size_t bytes) noexcept {
+      ++deallocations;
+      bytesInUse -= bytes;
+   }
+
+   void failed() noexcept {
+      ++failures;
+   }
+
+   void released() noexcept {}
+
+   // Статистика одной строкой JSON
+   std::string json() const {
+      std::string json{"{"};
+      auto field = [&json](const char* name, std::size_t value) {
+         if (json.size() > 1) json += ',';
+         json += '"';
+         json += name;
+         json += "\":" + std::to_string(value);
+      };
+      field("allocations", allocations);
+      field("deallocations", deallocations);
+      field("failures", failures);
+      field("bytes_in_use", bytesInUse);
+      field("peak_bytes", peakBytes);
+      field("blocks", blocks);
+      field("reserved_bytes", reservedBytes);
+      json += '}';
+      return json;
+   }
+};
+
+// Статистика, которая выводится в std::clog при освобождении пула.
+// Контейнеры перепривязывают аллокатор к типу узла и заводят для узлов
+// свой пул, недоступный снаружи; отчёт при освобождении показывает и его
+struct ReportStats : AllocStats {
+   void released() noexcept {
+      try {
+         std::clog << "pool " << json() << '\n';
+      }
+      catch (...) {
+         // Отчёт не должен мешать освобождению памяти
+      }
+   }
+};
@@ -0,0 +1,153 @@
+// arena_resource.hpp -- std::pmr::memory_resource над пулом StatefulPool
+// с ёмкостью, заданной при выполнении
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+
+#include "alloc_stats.hpp"
+#include "stateful_alloc.hpp"
+
+// Область ресурсов: места по granularity байт в одной области пула
+// StatefulPool, запрос занимает несколько мест подряд. Ёмкость задаётся
+// конструктором, а не параметром шаблона, поэтому контейнеры над
+// ресурсами разной ёмкости имеют один тип.
+// expandable = false -- при исчерпании области выделение считается ошибкой.
+// expandable = true -- выделяется следующий блок вдвое большей ёмкости,
+// как у StatefulAllocator<T, capacity, true>; прежние блоки не перемещаются
+template<bool expandable>
+class ResourceArea {
+public:
+   // Размер и выравнивание места
+   static constexpr std::size_t granularity{16};
+
+   using Pool = StatefulPool<0, expandable, NoStats>;
+private:
+   Pool m_pool;
+   typename Pool::Region* m_region;  // Единственная область пула
+public:
+   // capacity -- ёмкость первого блока в байтах
+   explicit ResourceArea(std::size_t capacity)
+      : m_pool{std::max<std::size_t>((capacity + granularity - 1) / granularity, 1)},
+      m_region{&m_pool.region(granularity, granularity)} {}
+
+   // Выделение bytes байт с выравниванием align (степень двойки).
+   // Место выровнено на granularity, большее выравнивание добирается
+   // сдвигом внутри запрошенных мест
+   void* allocate(std::size_t bytes, std::size_t align) {
+      std::size_t padding{align > granularity ? align - granularity : 0};
+      std::size_t slots{std::max<std::size_t>(
+         (bytes + padding + granularity - 1) / granularity, 1)};
+      auto address = reinterpret_cast<std::uintptr_t>(
+         m_pool.allocate(*m_region, slots));
+      return reinterpret_cast<void*>((address + align - 1) & ~(align - 1));
+   }
+
+   // Освобождение всей выделенной памяти: остаётся только первый блок
+   void release() noexcept {
+      m_pool.release();
+   }
+
+   // Пул области
+   const Pool& pool() const noexcept {
+      return m_pool;
+   }
+};
+
+// Монотонный ресурс: deallocate ничего не делает, память возвращается
+// вся сразу release() или деструктором. Подходит для контейнеров, которые
+// только растут, как map из main_test_map.cpp:
+//    ArenaResource arena{std::size_t{64} << 20};
+//    std::pmr::map<int, int> map{&arena};
+//    std::pmr::vector<int> values{&arena};
+template<bool expandable = false>
+class ArenaResource : public std::pmr::memory_resource {
+private:
+   ResourceArea<expandable> m_area;
+public:
+   explicit ArenaResource(std::size_t capacity)
+      : m_area{capacity} {}
+
+   void release() noexcept {
+      m_area.release();
+   }
+
+   const typename ResourceArea<expandable>::Pool& pool() const noexcept {
+      return m_area.pool();
+   }
+protected:
+   void* do_allocate(std::size_t bytes, std::size_t align) override {
+      return m_area.allocate(bytes, align);
+   }
+
+   void do_deallocate(void*, std::size_t, std::size_t) noexcept override {}
+
+   bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+      return this == &other;
+   }
+};
+
+// Ресурс с повторным использованием мест. Запросы до maxPooled байт
+// округляются до класса размера, кратного 16, и выделяются из области;
+// освобождённые места собираются в список своего класса, указатель на
+// следующее место хранится в самом месте, как у StatefulAllocator.
+// Большие запросы и выравнивание больше 16 передаются ресурсу upstream:
+// так освобождается, например, прежний буфер растущего std::pmr::vector
+template<bool expandable = false>
+class PoolResource : public std::pmr::memory_resource {
+public:
+   static constexpr std::size_t granularity{ResourceArea<expandable>::granularity};
+   static constexpr std::size_t maxPooled{512};   // Наибольший класс
+private:
+   static constexpr std::size_t classes{maxPooled / granularity};
+
+   ResourceArea<expandable> m_area;
+   std::pmr::memory_resource* m_upstream;  // Ресурс для больших запросов
+   std::array<void*, classes> m_free;       // Списки свободных мест
+
+   static bool pooled(std::size_t bytes, std::size_t align) noexcept {
+      return bytes <= maxPooled && align <= granularity;
+   }
+
+   // Номер класса размера, места класса i занимают (i + 1) * 16 байт
+   static std::size_t sizeClass(std::size_t bytes) noexcept {
+      return (std::max<std::size_t>(bytes, 1) - 1) / granularity;
+   }
+public:
+   explicit PoolResource(std::size_t capacity,
+      std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+      : m_area{capacity}, m_upstream{upstream}, m_free{} {}
+
+   const typename ResourceArea<expandable>::Pool& pool() const noexcept {
+      return m_area.pool();
+   }
+protected:
+   void* do_allocate(std::size_t bytes, std::size_t align) override {
+      if (!pooled(bytes, align)) return m_upstream->allocate(bytes, align);
+      std::size_t index{sizeClass(bytes)};
+      if (void* slot = m_free[index]) {
+         std::memcpy(&m_free[index], slot, sizeof(void*));
+         return slot;
+      }
+      return m_area.allocate((index + 1) * granularity, granularity);
+   }
+
+   void do_deallocate(void* p, std::size_t bytes, std::size_t align) noexcept override {
+      if (!pooled(bytes, align)) {
+         m_upstream->deallocate(p, bytes, align);
+         return;
+      }
+      std::size_t index{sizeClass(bytes)};
+      std::memcpy(p, &m_free[index], sizeof(void*));
+      m_free[index] = p;
+   }
+
+   bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+      return this == &other;
+   }
+};
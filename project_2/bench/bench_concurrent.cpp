@@ -0,0 +1,71 @@
+// bench_concurrent.cpp -- масштабирование по числу потоков: каждый поток
+// заполняет свой std::map<int, int> и удаляет его. Стандартный аллокатор
+// сравнивается с ConcurrentAllocator над общей областью
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../concurrent_alloc.hpp"
+
+// Элементов в map одного потока
+constexpr int threadKeys{100'000};
+
+using Pair = std::pair<const int, int>;
+
+// Заполнение и удаление map каждым из state.range(0) потоков.
+// Потоки запускаются внутри замера, поэтому время считается по часам
+template<typename Map, typename MakeMap>
+static void runThreads(benchmark::State& state, MakeMap makeMap) {
+   const int threads{static_cast<int>(state.range(0))};
+   for (auto _ : state) {
+      std::vector<std::jthread> workers{};
+      for (int t{}; t < threads; ++t) {
+         workers.emplace_back([&makeMap] {
+            Map map{makeMap()};
+            for (int key{}; key < threadKeys; ++key) {
+               map.emplace(key, key);
+            }
+            benchmark::DoNotOptimize(map.size());
+         });
+      }
+   }
+   state.SetItemsProcessed(state.iterations() * threads * threadKeys);
+}
+
+static void stdAllocator(benchmark::State& state) {
+   runThreads<std::map<int, int>>(state, [] {
+      return std::map<int, int>{};
+   });
+}
+
+// Область создаётся один раз на замер; узлы удалённых map используются
+// повторно потоками следующих итераций
+static void concurrentAllocator(benchmark::State& state) {
+   using Allocator = ConcurrentAllocator<Pair>;
+   using Map = std::map<int, int, std::less<int>, Allocator>;
+   auto arena = std::make_shared<ConcurrentArena>(std::size_t{1} << 30);
+   runThreads<Map>(state, [&arena] {
+      return Map{Allocator{arena}};
+   });
+}
+
+// Потоки: от одного до числа ядер, не меньше четырёх
+static void threads(benchmark::internal::Benchmark* bench) {
+   int limit{static_cast<int>(std::max(std::thread::hardware_concurrency(), 4u))};
+   for (int count{1}; count <= limit; count *= 2) {
+      bench->Arg(count);
+   }
+   bench->UseRealTime()->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK(stdAllocator)->Apply(threads);
+BENCHMARK(concurrentAllocator)->Apply(threads);
+
+BENCHMARK_MAIN();
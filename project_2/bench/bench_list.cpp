@@ -0,0 +1,89 @@
+// bench_list.cpp -- ChunkList против std::list и std::forward_list:
+// добавление в конец и обход элементов int
+
+#include <benchmark/benchmark.h>
+
+#include <forward_list>
+#include <list>
+#include <type_traits>
+
+#include "../chunk_list.hpp"
+#include "../cust_alloc.hpp"
+#include "../stateful_alloc.hpp"
+
+// Ёмкость пулов в блоках: блок по умолчанию вмещает 64 int, пула хватает
+// на наибольшее число элементов в замерах
+constexpr std::size_t chunkCapacity{(std::size_t{1} << 20) / 64 + 1};
+
+using StdList = std::list<int>;
+using StdForwardList = std::forward_list<int>;
+using StdChunkList = ChunkList<int>;
+using StatefulChunkList = ChunkList<int, StatefulAllocator<int, chunkCapacity>>;
+using CustChunkList = ChunkList<int, CustAllocator<int, chunkCapacity>>;
+
+// Добавление state.range(0) элементов в конец
+template<typename List>
+static void listAppend(benchmark::State& state) {
+   const int count{static_cast<int>(state.range(0))};
+   for (auto _ : state) {
+      List list{};
+      if constexpr (std::is_same_v<List, StdForwardList>) {
+         // У std::forward_list нет push_back, вставка после последнего
+         auto last = list.before_begin();
+         for (int i{}; i < count; ++i) {
+            last = list.insert_after(last, i);
+         }
+      }
+      else {
+         for (int i{}; i < count; ++i) {
+            list.push_back(i);
+         }
+      }
+      benchmark::DoNotOptimize(&list);
+   }
+   state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Обход заполненного контейнера
+template<typename List>
+static void listIterate(benchmark::State& state) {
+   const int count{static_cast<int>(state.range(0))};
+   List list{};
+   if constexpr (std::is_same_v<List, StdForwardList>) {
+      auto last = list.before_begin();
+      for (int i{}; i < count; ++i) {
+         last = list.insert_after(last, i);
+      }
+   }
+   else {
+      for (int i{}; i < count; ++i) {
+         list.push_back(i);
+      }
+   }
+   for (auto _ : state) {
+      long long sum{};
+      for (int value : list) {
+         sum += value;
+      }
+      benchmark::DoNotOptimize(sum);
+   }
+   state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void sizes(benchmark::internal::Benchmark* bench) {
+   bench->Arg(1'000)->Arg(100'000)->Arg(1'000'000)
+      ->Unit(benchmark::kMicrosecond);
+}
+
+BENCHMARK(listAppend<StdList>)->Apply(sizes);
+BENCHMARK(listAppend<StdForwardList>)->Apply(sizes);
+BENCHMARK(listAppend<StdChunkList>)->Apply(sizes);
+BENCHMARK(listAppend<StatefulChunkList>)->Apply(sizes);
+BENCHMARK(listAppend<CustChunkList>)->Apply(sizes);
+BENCHMARK(listIterate<StdList>)->Apply(sizes);
+BENCHMARK(listIterate<StdForwardList>)->Apply(sizes);
+BENCHMARK(listIterate<StdChunkList>)->Apply(sizes);
+BENCHMARK(listIterate<StatefulChunkList>)->Apply(sizes);
+BENCHMARK(listIterate<CustChunkList>)->Apply(sizes);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,124 @@
+// bench_map.cpp -- std::map<int, int> со стандартным аллокатором,
+// StatefulAllocator и CustAllocator: вставка, обход и чередование
+// вставки и удаления
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "../cust_alloc.hpp"
+#include "../stateful_alloc.hpp"
+
+// Ёмкость пулов, больше наибольшего числа элементов в замерах
+constexpr std::size_t poolCapacity{std::size_t{1} << 20};
+
+using Pair = std::pair<const int, int>;
+using StdMap = std::map<int, int>;
+using StatefulMap = std::map<int, int, std::less<int>,
+   StatefulAllocator<Pair, poolCapacity>>;
+using CustMap = std::map<int, int, std::less<int>,
+   CustAllocator<Pair, poolCapacity>>;
+// Расширяемый пул с маленьким первым блоком
+using ExpandableMap = std::map<int, int, std::less<int>,
+   StatefulAllocator<Pair, 16, true>>;
+
+// Пулы для чередования вставки и удаления: живых элементов не больше
+// churnLive, освобождённые места используются повторно
+constexpr int churnLive{1000};
+using StatefulChurnMap = std::map<int, int, std::less<int>,
+   StatefulAllocator<Pair, churnLive + 1>>;
+using CustChurnMap = std::map<int, int, std::less<int>,
+   CustAllocator<Pair, churnLive + 1>>;
+
+// Ключи 0..size-1 в случайном порядке, одинаковом от запуска к запуску
+static std::vector<int> shuffledKeys(std::size_t size) {
+   std::vector<int> keys(size);
+   std::iota(keys.begin(), keys.end(), 0);
+   std::shuffle(keys.begin(), keys.end(), std::mt19937{42});
+   return keys;
+}
+
+// Создание контейнера и вставка state.range(0) элементов.
+// Время включает создание пула аллокатора и освобождение памяти
+template<typename Map>
+static void mapInsert(benchmark::State& state) {
+   const auto keys = shuffledKeys(static_cast<std::size_t>(state.range(0)));
+   for (auto _ : state) {
+      Map map{};
+      for (int key : keys) {
+         map.emplace(key, key);
+      }
+      benchmark::DoNotOptimize(map.size());
+   }
+   state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Обход заполненного контейнера
+template<typename Map>
+static void mapIterate(benchmark::State& state) {
+   Map map{};
+   for (int key : shuffledKeys(static_cast<std::size_t>(state.range(0)))) {
+      map.emplace(key, key);
+   }
+   for (auto _ : state) {
+      long long sum{};
+      for (const auto& [key, value] : map) {
+         sum += value;
+      }
+      benchmark::DoNotOptimize(sum);
+   }
+   state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Чередование: state.range(0) пар "вставка нового ключа -- удаление
+// самого старого" при churnLive живых элементах. Без повторного
+// использования мест пулы на churnLive + 1 элемент исчерпались бы сразу.
+// peak_rss_kb -- пиковый объём памяти процесса после замера
+template<typename Map>
+static void mapChurn(benchmark::State& state) {
+   const int steps{static_cast<int>(state.range(0))};
+   for (auto _ : state) {
+      Map map{};
+      for (int key{}; key < churnLive; ++key) {
+         map.emplace(key, key);
+      }
+      for (int step{}; step < steps; ++step) {
+         map.emplace(step + churnLive, step);
+         map.erase(step);
+      }
+      benchmark::DoNotOptimize(map.size());
+   }
+   rusage usage{};
+   ::getrusage(RUSAGE_SELF, &usage);
+   state.counters["peak_rss_kb"] = static_cast<double>(usage.ru_maxrss);
+   state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void sizes(benchmark::internal::Benchmark* bench) {
+   bench->Arg(10)->Arg(1'000)->Arg(100'000)->Arg(1'000'000)
+      ->Unit(benchmark::kMicrosecond);
+}
+
+BENCHMARK(mapInsert<StdMap>)->Apply(sizes);
+BENCHMARK(mapInsert<StatefulMap>)->Apply(sizes);
+BENCHMARK(mapInsert<CustMap>)->Apply(sizes);
+BENCHMARK(mapInsert<ExpandableMap>)->Apply(sizes);
+BENCHMARK(mapIterate<StdMap>)->Apply(sizes);
+BENCHMARK(mapIterate<StatefulMap>)->Apply(sizes);
+BENCHMARK(mapIterate<CustMap>)->Apply(sizes);
+BENCHMARK(mapIterate<ExpandableMap>)->Apply(sizes);
+
+BENCHMARK(mapChurn<StdMap>)->Arg(10'000'000)->Unit(benchmark::kMillisecond);
+BENCHMARK(mapChurn<StatefulChurnMap>)->Arg(10'000'000)->Unit(benchmark::kMillisecond);
+BENCHMARK(mapChurn<CustChurnMap>)->Arg(10'000'000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,95 @@
+// bench_pmr.cpp -- задача main_test_map.cpp на 1e6 ключей: map "ключ --
+// факториал" на ресурсах std::pmr и на StatefulAllocator
+
+#include <benchmark/benchmark.h>
+
+#include <functional>
+#include <map>
+#include <memory_resource>
+#include <utility>
+
+#include "../arena_resource.hpp"
+#include "../stateful_alloc.hpp"
+
+// Число ключей
+constexpr int keyCount{1'000'000};
+// Объём области: узел std::map<int, int> занимает 40 байт
+constexpr std::size_t arenaBytes{std::size_t{keyCount} * 48};
+
+using Pair = std::pair<const int, int>;
+using StatefulMap = std::map<int, int, std::less<int>,
+   StatefulAllocator<Pair, keyCount>>;
+
+// Факториал ключа; чтобы не переполнить int, по модулю 13
+static int factorial(int n) {
+   int result{1};
+   for (int i{2}; i <= n % 13; ++i) {
+      result *= i;
+   }
+   return result;
+}
+
+// Заполнение map ключами 0..keyCount-1 и обход
+template<typename Map>
+static void fillAndSum(Map& map) {
+   for (int i{}; i < keyCount; ++i) {
+      map[i] = factorial(i);
+   }
+   long long sum{};
+   for (const auto& [key, value] : map) {
+      sum += value;
+   }
+   benchmark::DoNotOptimize(sum);
+}
+
+static void stdMap(benchmark::State& state) {
+   for (auto _ : state) {
+      std::map<int, int> map{};
+      fillAndSum(map);
+   }
+   state.SetItemsProcessed(state.iterations() * keyCount);
+}
+
+static void statefulMap(benchmark::State& state) {
+   for (auto _ : state) {
+      StatefulMap map{};
+      fillAndSum(map);
+   }
+   state.SetItemsProcessed(state.iterations() * keyCount);
+}
+
+// Стандартный монотонный ресурс с начальным буфером того же объёма
+static void pmrMonotonic(benchmark::State& state) {
+   for (auto _ : state) {
+      std::pmr::monotonic_buffer_resource resource{arenaBytes};
+      std::pmr::map<int, int> map{&resource};
+      fillAndSum(map);
+   }
+   state.SetItemsProcessed(state.iterations() * keyCount);
+}
+
+static void pmrArena(benchmark::State& state) {
+   for (auto _ : state) {
+      ArenaResource resource{arenaBytes};
+      std::pmr::map<int, int> map{&resource};
+      fillAndSum(map);
+   }
+   state.SetItemsProcessed(state.iterations() * keyCount);
+}
+
+static void pmrPool(benchmark::State& state) {
+   for (auto _ : state) {
+      PoolResource resource{arenaBytes};
+      std::pmr::map<int, int> map{&resource};
+      fillAndSum(map);
+   }
+   state.SetItemsProcessed(state.iterations() * keyCount);
+}
+
+BENCHMARK(stdMap)->Unit(benchmark::kMillisecond);
+BENCHMARK(statefulMap)->Unit(benchmark::kMillisecond);
+BENCHMARK(pmrMonotonic)->Unit(benchmark::kMillisecond);
+BENCHMARK(pmrArena)->Unit(benchmark::kMillisecond);
+BENCHMARK(pmrPool)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,251 @@
+// chunk_list.hpp -- однонаправленный контейнер из блоков элементов
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Число элементов в блоке по умолчанию: блок около 256 байт, но не меньше
+// четырёх элементов
+template<typename T>
+inline constexpr std::size_t defaultChunkSize{
+   std::max<std::size_t>(4, 256 / sizeof(T))};
+
+// Контейнер с добавлением в конец и обходом в одном направлении.
+// Элементы лежат подряд в блоках по chunkSize штук, блоки связаны в
+// список. Обход идёт по памяти последовательно и переходит по указателю
+// только раз на блок, а не на каждый элемент, как std::list.
+// Память под блоки берётся у Allocator, перепривязанного к типу блока,
+// поэтому ёмкость пула аллокатора считается в блоках: CustAllocator<T, 10>
+// вмещает 10 блоков. Аллокатор блоков создаётся конструктором по
+// умолчанию -- так его создают и StatefulAllocator, и CustAllocator --
+// или перепривязывается из переданного аллокатора, как у
+// ConcurrentAllocator, у которого конструктора по умолчанию нет
+template<typename T, typename Allocator = std::allocator<T>,
+   std::size_t chunkSize = defaultChunkSize<T>>
+class ChunkList {
+   static_assert(chunkSize > 0);
+private:
+   // Блок элементов
+   struct Chunk {
+      Chunk* next;          // Следующий блок
+      std::size_t count;    // Занято мест в блоке
+      alignas(T) unsigned char storage[chunkSize * sizeof(T)];
+
+      T* data() noexcept {
+         return std::launder(reinterpret_cast<T*>(storage));
+      }
+   };
+
+   using ChunkAllocator = typename std::allocator_traits<Allocator>
+      ::template rebind_alloc<Chunk>;
+   using Traits = std::allocator_traits<ChunkAllocator>;
+
+   ChunkAllocator m_allocator; // Аллокатор блоков
+   Chunk* m_head;              // Первый блок
+   Chunk* m_tail;              // Последний блок
+   std::size_t m_size;         // Число элементов
+
+   // Новый блок с первым элементом. Блок присоединяется к списку только
+   // после создания элемента, поэтому пустых блоков в списке не бывает
+   template<typename... Args>
+   T* appendChunk(Args&&... args) {
+      Chunk* chunk{Traits::allocate(m_allocator, 1)};
+      ::new (static_cast<void*>(chunk)) Chunk;
+      chunk->next = nullptr;
+      chunk->count = 0;
+      try {
+         Traits::construct(m_allocator, chunk->data(), std::forward<Args>(args)...);
+      }
+      catch (...) {
+         Traits::deallocate(m_allocator, chunk, 1);
+         throw;
+      }
+      (m_tail ? m_tail->next : m_head) = chunk;
+      m_tail = chunk;
+      return chunk->data();
+   }
+
+   // Однонаправленный итератор, Const -- только для чтения
+   template<bool Const>
+   class Iterator {
+   private:
+      Chunk* m_chunk;       // Текущий блок, nullptr -- конец
+      std::size_t m_index;  // Номер элемента в блоке
+
+      friend class ChunkList;
+
+      Iterator(Chunk* chunk, std::size_t index) noexcept
+         : m_chunk{chunk}, m_index{index} {}
+   public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = T;
+      using difference_type = std::ptrdiff_t;
+      using pointer = std::conditional_t<Const, const T*, T*>;
+      using reference = std::conditional_t<Const, const T&, T&>;
+
+      Iterator() noexcept : m_chunk{nullptr}, m_index{} {}
+
+      // Итератор для чтения из обычного
+      template<bool OtherConst>
+         requires (Const && !OtherConst)
+      Iterator(const Iterator<OtherConst>& other) noexcept
+         : m_chunk{other.m_chunk}, m_index{other.m_index} {}
+
+      reference operator*() const noexcept {
+         return m_chunk->data()[m_index];
+      }
+
+      pointer operator->() const noexcept {
+         return m_chunk->data() + m_index;
+      }
+
+      Iterator& operator++() noexcept {
+         if (++m_index == m_chunk->count) {
+            m_chunk = m_chunk->next;
+            m_index = 0;
+         }
+         return *this;
+      }
+
+      Iterator operator++(int) noexcept {
+         Iterator previous{*this};
+         ++*this;
+         return previous;
+      }
+
+      bool operator==(const Iterator&) const noexcept = default;
+   };
+public:
+   using value_type = T;
+   using allocator_type = Allocator;
+   using size_type = std::size_t;
+   using difference_type = std::ptrdiff_t;
+   using reference = T&;
+   using const_reference = const T&;
+   using iterator = Iterator<false>;
+   using const_iterator = Iterator<true>;
+
+   // Конструктор по умолчанию
+   ChunkList()
+      : m_allocator{}, m_head{nullptr}, m_tail{nullptr}, m_size{} {}
+
+   // Конструктор с аллокатором: блоки берутся у его rebind-версии
+   explicit ChunkList(const Allocator& allocator)
+      : m_allocator{allocator}, m_head{nullptr}, m_tail{nullptr}, m_size{} {}
+
+   // Копирующий конструктор запрещён
+   ChunkList(const ChunkList&) = delete;
+
+   // Конструктор копирующего присваивания запрещён
+   ChunkList& operator=(const ChunkList&) = delete;
+
+   // Перемещающий конструктор: блоки переходят вместе с аллокатором.
+   // CustAllocator не перемещается, контейнер с ним -- тоже
+   ChunkList(ChunkList&& other) noexcept
+      requires std::is_nothrow_move_constructible_v<ChunkAllocator>
+      : m_allocator{std::move(other.m_allocator)},
+      m_head{std::exchange(other.m_head, nullptr)},
+      m_tail{std::exchange(other.m_tail, nullptr)},
+      m_size{std::exchange(other.m_size, 0)} {}
+
+   // Конструктор перемещающего присваивания: аллокатор должен переходить
+   // вместе с блоками, иначе блоки освобождались бы чужим аллокатором
+   ChunkList& operator=(ChunkList&& other) noexcept
+      requires (Traits::propagate_on_container_move_assignment::value
+         && std::is_nothrow_move_assignable_v<ChunkAllocator>) {
+      if (this != &other) {
+         clear();
+         m_allocator = std::move(other.m_allocator);
+         m_head = std::exchange(other.m_head, nullptr);
+         m_tail = std::exchange(other.m_tail, nullptr);
+         m_size = std::exchange(other.m_size, 0);
+      }
+      return *this;
+   }
+
+   // Деструктор
+   ~ChunkList() {
+      clear();
+   }
+
+   // Добавление элемента в конец
+   template<typename... Args>
+   T& emplace_back(Args&&... args) {
+      T* slot{nullptr};
+      if (m_tail && m_tail->count < chunkSize) {
+         slot = m_tail->data() + m_tail->count;
+         Traits::construct(m_allocator, slot, std::forward<Args>(args)...);
+      }
+      else {
+         slot = appendChunk(std::forward<Args>(args)...);
+      }
+      ++m_tail->count;
+      ++m_size;
+      return *slot;
+   }
+
+   void push_back(const T& value) {
+      emplace_back(value);
+   }
+
+   void push_back(T&& value) {
+      emplace_back(std::move(value));
+   }
+
+   // Аллокатор контейнера, перепривязанный обратно к типу элементов
+   allocator_type get_allocator() const {
+      return allocator_type{m_allocator};
+   }
+
+   // Удаление всех элементов и возврат блоков аллокатору
+   void clear() noexcept {
+      for (Chunk* chunk{m_head}; chunk;) {
+         Chunk* next{chunk->next};
+         for (std::size_t i{}; i < chunk->count; ++i) {
+            Traits::destroy(m_allocator, chunk->data() + i);
+         }
+         Traits::deallocate(m_allocator, chunk, 1);
+         chunk = next;
+      }
+      m_head = m_tail = nullptr;
+      m_size = 0;
+   }
+
+   iterator begin() noexcept {
+      return {m_head, 0};
+   }
+
+   iterator end() noexcept {
+      return {};
+   }
+
+   const_iterator begin() const noexcept {
+      return {m_head, 0};
+   }
+
+   const_iterator end() const noexcept {
+      return {};
+   }
+
+   const_iterator cbegin() const noexcept {
+      return begin();
+   }
+
+   const_iterator cend() const noexcept {
+      return end();
+   }
+
+   std::size_t size() const noexcept {
+      return m_size;
+   }
+
+   bool empty() const noexcept {
+      return m_size == 0;
+   }
+};
@@ -0,0 +1,281 @@
+// concurrent_alloc.hpp -- пул памяти, общий для нескольких потоков
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Общая для потоков область памяти фиксированного размера.
+// Область делится на слэбы по slabSize байт. Поток забирает себе слэб
+// целиком одним атомарным увеличением счётчика, без блокировок, и дальше
+// раздаёт из него места одного размера через свой кеш, без синхронизации.
+// Кеш заводится для каждой пары "поток -- размер места".
+// Освобождённое место возвращается в кеш потока-владельца слэба:
+//  - своим потоком -- в локальный список свободных мест;
+//  - другим потоком -- в атомарный стек владельца (push через CAS);
+//    владелец забирает стек целиком одной операцией exchange, когда
+//    локальный список пуст. Стек только пополняется и забирается целиком,
+//    поэтому проблемы ABA нет.
+// Кеш завершившегося потока помечается брошенным, и первый новый поток,
+// которому нужен кеш того же размера, забирает его вместе со слэбами и
+// свободными местами. Блокировка берётся только при заведении кеша --
+// один раз на поток и размер места. Освобождение кеш не заводит: поток
+// без своего кеша возвращает место владельцу через стек
+class ConcurrentArena {
+public:
+   // Размер слэба в байтах
+   static constexpr std::size_t slabSize{std::size_t{64} << 10};
+private:
+   // Кеш одного потока для мест одного размера
+   struct ThreadCache {
+      std::size_t slotSize;           // Размер места
+      char* current;                  // Свободная часть текущего слэба
+      char* end;                      // Конец текущего слэба
+      void* free;                     // Места, освобождённые своим потоком
+      std::atomic<void*> remote;      // Места, освобождённые другими потоками
+      std::atomic<bool> orphaned;     // Поток кеша завершился
+
+      explicit ThreadCache(std::size_t size) noexcept
+         : slotSize{size}, current{nullptr}, end{nullptr}, free{nullptr},
+         remote{nullptr}, orphaned{false} {}
+   };
+
+   // Запись таблицы кешей потока. Кеш принадлежит и области, и потоку:
+   // пометка брошенного кеша при завершении потока безопасна, даже если
+   // область уже уничтожена. Записи уничтоженных областей узнаются по
+   // истёкшему alive и удаляются при заведении следующего кеша потока
+   struct LocalEntry {
+      std::uint64_t arena;                // Номер области
+      std::weak_ptr<const char> alive;    // Признак жизни области
+      std::shared_ptr<ThreadCache> cache; // Кеш потока
+   };
+
+   // Таблица кешей потока, при завершении потока кеши помечаются брошенными
+   struct LocalCaches {
+      std::vector<LocalEntry> entries;
+
+      ~LocalCaches() {
+         for (const LocalEntry& entry : entries) {
+            entry.cache->orphaned.store(true, std::memory_order_release);
+         }
+      }
+   };
+
+   std::uint64_t m_id;                   // Номер области, не повторяется
+   std::shared_ptr<const char> m_alive;  // Истекает вместе с областью
+   char* m_base;                         // Начало области
+   std::size_t m_slabs;                  // Всего слэбов
+   std::atomic<std::size_t> m_nextSlab;  // Первый не выданный слэб
+   std::unique_ptr<ThreadCache*[]> m_owners; // Владелец каждого слэба
+   std::mutex m_cachesMutex;             // Защищает m_caches
+   std::vector<std::shared_ptr<ThreadCache>> m_caches; // Все кеши области
+
+   static std::uint64_t nextId() noexcept {
+      static std::atomic<std::uint64_t> counter{0};
+      return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+   }
+
+   [[noreturn]] static void exhausted() {
+      std::cerr << "Ошибка: недостаточно памяти!\n";
+      throw std::bad_alloc{};
+   }
+
+   // Таблица кешей текущего потока
+   static LocalCaches& locals() noexcept {
+      thread_local LocalCaches local{};
+      return local;
+   }
+
+   // Уже заведённый кеш текущего потока для мест размера slotSize,
+   // nullptr -- кеша нет. Новый кеш не заводится
+   ThreadCache* findCache(std::size_t slotSize) const noexcept {
+      for (const LocalEntry& entry : locals().entries) {
+         if (entry.arena == m_id && entry.cache->slotSize == slotSize) {
+            return entry.cache.get();
+         }
+      }
+      return nullptr;
+   }
+
+   // Кеш текущего потока для мест размера slotSize, заводится при
+   // первом обращении
+   ThreadCache* localCache(std::size_t slotSize) {
+      if (ThreadCache* cache = findCache(slotSize)) return cache;
+      LocalCaches& local{locals()};
+      std::erase_if(local.entries, [](const LocalEntry& entry) {
+         return entry.alive.expired();
+      });
+      local.entries.reserve(local.entries.size() + 1);
+      std::lock_guard lock{m_cachesMutex};
+      std::shared_ptr<ThreadCache> cache{};
+      // Сначала брошенный кеш того же размера
+      for (const auto& candidate : m_caches) {
+         bool orphaned{true};
+         if (candidate->slotSize == slotSize
+            && candidate->orphaned.compare_exchange_strong(orphaned, false,
+               std::memory_order_acquire)) {
+            cache = candidate;
+            break;
+         }
+      }
+      if (!cache) {
+         cache = std::make_shared<ThreadCache>(slotSize);
+         m_caches.push_back(cache);
+      }
+      local.entries.push_back({m_id, m_alive, cache});
+      return cache.get();
+   }
+
+   // Выдача count подряд идущих слэбов владельцу owner
+   char* takeSlabs(std::size_t count, ThreadCache* owner) {
+      std::size_t first{m_nextSlab.fetch_add(count, std::memory_order_relaxed)};
+      if (first + count > m_slabs || first + count < first) exhausted();
+      for (std::size_t i{}; i < count; ++i) {
+         m_owners[first + i] = owner;
+      }
+      return m_base + first * slabSize;
+   }
+
+   // Размер места: не меньше указателя и кратен выравниванию
+   static std::size_t slotSize(std::size_t size, std::size_t align) noexcept {
+      align = std::max(align, alignof(void*));
+      size = std::max(size, sizeof(void*));
+      return (size + align - 1) / align * align;
+   }
+public:
+   // bytes -- объём области, округляется вверх до целого числа слэбов
+   explicit ConcurrentArena(std::size_t bytes)
+      : m_id{nextId()}, m_alive{std::make_shared<char>()}, m_base{nullptr},
+      m_slabs{std::max<std::size_t>((bytes + slabSize - 1) / slabSize, 1)},
+      m_nextSlab{0}, m_owners{new ThreadCache*[m_slabs]{}}, m_cachesMutex{},
+      m_caches{} {
+         m_base = static_cast<char*>(::operator new (m_slabs * slabSize,
+            std::align_val_t{64}));
+   }
+
+   // Деструктор
+   ~ConcurrentArena() {
+      ::operator delete (m_base, std::align_val_t{64});
+   }
+
+   // Копирующий конструктор запрещён
+   ConcurrentArena(const ConcurrentArena&) = delete;
+
+   // Конструктор копирующего присваивания запрещён
+   ConcurrentArena& operator=(const ConcurrentArena&) = delete;
+
+   // Выделение size байт с выравниванием align (не больше 64)
+   void* allocate(std::size_t size, std::size_t align) {
+      ThreadCache* cache{localCache(slotSize(size, align))};
+      // Своё освобождённое место
+      if (!cache->free) {
+         // Места, возвращённые другими потоками, забираются все сразу
+         cache->free = cache->remote.exchange(nullptr, std::memory_order_acquire);
+      }
+      if (cache->free) {
+         void* slot = cache->free;
+         std::memcpy(&cache->free, slot, sizeof(void*));
+         return slot;
+      }
+      // Новое место из текущего слэба
+      if (static_cast<std::size_t>(cache->end - cache->current) < cache->slotSize) {
+         // Место больше слэба занимает несколько слэбов подряд
+         std::size_t count{(cache->slotSize + slabSize - 1) / slabSize};
+         cache->current = takeSlabs(count, cache);
+         cache->end = cache->current + count * slabSize;
+      }
+      void* slot = cache->current;
+      cache->current += cache->slotSize;
+      return slot;
+   }
+
+   // Возврат места, выделенного allocate(size, align) в любом потоке
+   void deallocate(void* p, std::size_t size, std::size_t align) noexcept {
+      if (!p) return;
+      std::size_t slab{static_cast<std::size_t>(static_cast<char*>(p) - m_base)
+         / slabSize};
+      ThreadCache* owner{m_owners[slab]};
+      if (owner == findCache(slotSize(size, align))) {
+         std::memcpy(p, &owner->free, sizeof(void*));
+         owner->free = p;
+         return;
+      }
+      void* head{owner->remote.load(std::memory_order_relaxed)};
+      do {
+         std::memcpy(p, &head, sizeof(void*));
+      } while (!owner->remote.compare_exchange_weak(head, p,
+         std::memory_order_release, std::memory_order_relaxed));
+   }
+
+   // Выдано слэбов
+   std::size_t slabsUsed() const noexcept {
+      return std::min(m_nextSlab.load(std::memory_order_relaxed), m_slabs);
+   }
+
+   // Всего слэбов
+   std::size_t slabs() const noexcept {
+      return m_slabs;
+   }
+
+   // Число записей в таблице кешей текущего потока по всем областям
+   static std::size_t threadCaches() noexcept {
+      return locals().entries.size();
+   }
+};
+
+// Аллокатор над общей областью. Все копии и все rebind-версии аллокатора
+// (например, узлы std::map) работают с одной областью, поэтому
+// контейнеры рабочих потоков можно строить из общей памяти:
+//    auto arena = std::make_shared<ConcurrentArena>(std::size_t{1} << 30);
+//    std::map<int, int, std::less<int>, ConcurrentAllocator<Pair>> map{
+//       ConcurrentAllocator<Pair>{arena}};
+template<typename T>
+class ConcurrentAllocator {
+public:
+   using value_type = T;
+   using propagate_on_container_copy_assignment = std::true_type;
+   using propagate_on_container_move_assignment = std::true_type;
+   using propagate_on_container_swap = std::true_type;
+private:
+   std::shared_ptr<ConcurrentArena> m_arena;
+
+   template<typename U>
+   friend class ConcurrentAllocator;
+public:
+   // Конструктор над общей областью
+   explicit ConcurrentAllocator(std::shared_ptr<ConcurrentArena> arena) noexcept
+      : m_arena{std::move(arena)} {}
+
+   // Конструктор rebind-версии: та же область
+   template<typename U>
+   ConcurrentAllocator(const ConcurrentAllocator<U>& other) noexcept
+      : m_arena{other.m_arena} {}
+
+   T* allocate(std::size_t n) {
+      return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+   }
+
+   void deallocate(T* p, std::size_t n) noexcept {
+      m_arena->deallocate(p, n * sizeof(T), alignof(T));
+   }
+
+   // Общая область
+   const std::shared_ptr<ConcurrentArena>& arena() const noexcept {
+      return m_arena;
+   }
+
+   template<typename U>
+   bool operator==(const ConcurrentAllocator<U>& other) const noexcept {
+      return m_arena == other.m_arena;
+   }
+};
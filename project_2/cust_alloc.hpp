@@ -1,23 +1,42 @@
-// cust_alloc.hpp -- 
+// cust_alloc.hpp -- аллокатор с фиксированным блоком
+
+#pragma once
+
 #include <cstddef>
+#include <cstring>
+#include <iostream>
 #include <new>
-template<typename T, std::size_t size>
+#include "alloc_stats.hpp"
+
+// Освобождённые элементы не теряются: каждое освобождённое место
+// становится звеном односвязного списка, указатель на следующее звено
+// хранится в самом месте. allocate(1) сначала берёт место из списка,
+// последним освобождённым (ещё в кеше), и только потом из блока.
+// Для типов меньше указателя список не ведётся.
+// Stats -- политика статистики блока (alloc_stats.hpp), по умолчанию
+// NoStats без затрат.
+// Аллокатор не копируется, поэтому std::map создаёт для узлов отдельный
+// экземпляр через rebind. Блок резервируется при первом выделении, и
+// экземпляр, который память не выделяет (с типом std::pair), блока не занимает
+template<typename T, std::size_t size, typename Stats = NoStats>
 class CustAllocator {
 public:
    using value_type = T;
 private:
+   // Место элемента вмещает указатель на следующее свободное место
+   static constexpr bool reusable{sizeof(T) >= sizeof(void*)};
+
    void* m_block; // Указатель на начало блока памяти
    T* m_current;  // Указатель на свободный текущий блок памяти
    std::size_t m_capacity; // Максимальная ёмкость блока памяти
    std::size_t m_allocated;  // Всего размещено элементов
+   void* m_free;  // Список освобождённых мест
+   [[no_unique_address]] Stats m_stats; // Статистика блока
 public:
    // Конструктор по умолчанию
    CustAllocator() noexcept
-      : m_block{nullptr}, m_current{nullptr}, m_capacity{size}, m_allocated{} {
-         m_block = (::operator new (m_capacity * sizeof(T),
-         std::align_val_t{alignof(T)}));
-         m_current = static_cast<T*>(m_block);
-   }
+      : m_block{nullptr}, m_current{nullptr}, m_capacity{size}, m_allocated{},
+      m_free{nullptr}, m_stats{} {}
 
    // Конструктор копирования
    CustAllocator(const CustAllocator& original) noexcept = delete;
@@ -27,6 +46,7 @@ public:
 
    // Деструктор
    ~CustAllocator() {
+      m_stats.released();
       // Уничтожаем аллоцированные объекты
       if (m_block) {
          for (std::size_t i{}; i < m_allocated; ++i) {
@@ -48,21 +68,53 @@ public:
    }
 
    T* allocate(std::size_t n) {
+      // Сначала повторно используем освобождённое место
+      if constexpr (reusable) {
+         if (n == 1 && m_free) {
+            void* slot = m_free;
+            std::memcpy(&m_free, slot, sizeof(void*));
+            m_stats.allocated(sizeof(T));
+            return static_cast<T*>(slot);
+         }
+      }
+      // Блок резервируется при первом выделении
+      if (!m_block) {
+         m_block = (::operator new (m_capacity * sizeof(T),
+         std::align_val_t{alignof(T)}));
+         m_current = static_cast<T*>(m_block);
+         m_stats.block(m_capacity * sizeof(T));
+      }
       // проверяем наличие памяти в блоке
       if (m_allocated + n > m_capacity) {
+         m_stats.failed();
          std::cerr << "Ошибка: Не достаточно памяти!\n";
          throw std::bad_alloc{};
       }
       auto ptr = m_current;
       m_current += n;
       m_allocated += n;
+      m_stats.allocated(n * sizeof(T));
       return ptr;
    }
 
-   void deallocate(T*, std::size_t) {}
+   // Освобождённые места добавляются в начало списка
+   void deallocate(T* p, std::size_t n) noexcept {
+      m_stats.deallocated(n * sizeof(T));
+      if constexpr (reusable) {
+         for (std::size_t i{}; i < n; ++i) {
+            std::memcpy(static_cast<void*>(p + i), &m_free, sizeof(void*));
+            m_free = p + i;
+         }
+      }
+   }
 
    template<typename U>
    struct rebind {
-      using other = CustAllocator<U, size>;
+      using other = CustAllocator<U, size, Stats>;
    };
+
+   // Статистика блока, есть только у аллокатора с политикой AllocStats
+   const Stats& stats() const noexcept requires Stats::enabled {
+      return m_stats;
+   }
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <map>
 #include <format>
 #include "stateful_alloc.hpp"
+#include "chunk_list.hpp"
 
 // Вычисление факториала
 int factorial(int n) {
@@ -119,4 +120,60 @@ int main() {
          std::cout << std::format("{} {}\n", pair.first, pair.second);
       }
    }
+
+   // Тестируем расширение: пул на 4 элемента дополняется новыми блоками
+   {
+      std::cout << std::endl;
+      using Allocator = StatefulAllocator<std::pair<const int, int>, 4, true>;
+      std::map<int, int, std::less<int>, Allocator> grow_map;
+      for (int i{}; i < 10; ++i) {
+         grow_map[i] = factorial(i);
+      }
+      std::cout << "Расширяемый пул:\n";
+      for (const auto& pair : grow_map) {
+         std::cout << std::format("{} {}\n", pair.first, pair.second);
+      }
+   }
+
+   // Тестируем общий пул: аллокатор std::pair и аллокатор узлов делят
+   // один пул, память резервируется один раз и только под узлы
+   {
+      std::cout << std::endl;
+      using Allocator = StatefulAllocator<std::pair<const int, int>, 10,
+         false, AllocStats>;
+      std::map<int, int, std::less<int>, Allocator> stats_map{Allocator{}};
+      for (int i{}; i < 10; ++i) {
+         stats_map[i] = factorial(i);
+      }
+      std::cout << "Статистика пула:\n"
+         << stats_map.get_allocator().stats().json() << '\n';
+   }
+
+   // Свой контейнер со стандартным аллокатором
+   {
+      std::cout << std::endl;
+      ChunkList<int> list;
+      for (int i{}; i < 10; ++i) {
+         list.push_back(i);
+      }
+      std::cout << "Свой контейнер со стандартным аллокатором:\n";
+      for (int value : list) {
+         std::cout << std::format("{}\n", value);
+      }
+   }
+
+   // Свой контейнер с аллокатором, ограниченным 10-ю элементами:
+   // блок вмещает 10 элементов, пул -- один блок
+   {
+      std::cout << std::endl;
+      using Allocator = StatefulAllocator<int, 1>;
+      ChunkList<int, Allocator, 10> list;
+      for (int i{}; i < 10; ++i) {
+         list.push_back(i);
+      }
+      std::cout << "Свой контейнер с пулом:\n";
+      for (int value : list) {
+         std::cout << std::format("{}\n", value);
+      }
+   }
 }
@@ -1,61 +1,249 @@
 // stateful_alloc.hpp -- заголовочный файл stateful-аллокатора
 
+#pragma once
+
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <new>
 #include <memory>
 #include <iostream>
+#include <vector>
+#include "alloc_stats.hpp"
 
-template<typename T, std::size_t capacity>
-class StatefulAllocator {
+// Пул аллокатора, общий для всех его копий и rebind-версий. Пул не
+// зависит от типа элементов: память делится на области по классам
+// размера (размер и выравнивание места), область класса заводится при
+// первом выделении места этого размера. Поэтому std::map, который
+// перепривязывает аллокатор к типу узла, резервирует память только под
+// узлы, а не ещё и под std::pair.
+// capacity -- число мест в первом блоке каждой области по умолчанию,
+// конструктор пула может задать его при выполнении.
+// expandable -- при исчерпании блока область переходит к следующему блоку
+// вдвое большей ёмкости, иначе выделение считается ошибкой
+template<std::size_t capacity, bool expandable, typename Stats>
+class StatefulPool {
 public:
-   using value_type = T;
-   using propagate_on_contaoner_copy_assignment = std::true_type;
-   using propagate_on_container_move_assignment = std::true_type;
-   using propagate_on_contaoner_swap = std::true_type;
-private:
-   struct Memory {
-      void* m_pool;
-      T* m_current;  
-      std::size_t m_capacity;
-      std::size_t m_allocated;
-
-      // Конструктор по умолчанию
-      explicit Memory(std::size_t cap) noexcept
-         : m_pool{nullptr}, m_current{nullptr}, m_capacity{cap},
-         m_allocated{} {
-            m_pool = ::operator new (m_capacity * sizeof(T),
-               std::align_val_t{alignof(T)});
-            m_current = static_cast<T*>(m_pool);
-      } 
-
-      // деструктор
-      ~Memory() {
-         ::operator delete (m_pool,
-            std::align_val_t{alignof(T)});
+   // Область мест одного класса размера
+   struct Region {
+      std::size_t m_slotSize;       // Размер места
+      std::size_t m_align;          // Выравнивание места
+      void* m_pool;                 // Текущий блок
+      char* m_current;              // Свободная часть текущего блока
+      std::size_t m_capacity;       // Ёмкость текущего блока в местах
+      std::size_t m_firstCapacity;  // Ёмкость первого блока в местах
+      std::size_t m_allocated;      // Выдано мест текущего блока
+      std::vector<void*> m_blocks;  // Заполненные блоки цепочки
+      void* m_free;                 // Список освобождённых мест
+
+      // Конструктор
+      Region(std::size_t slotSize, std::size_t align, std::size_t firstCapacity)
+         : m_slotSize{slotSize}, m_align{align}, m_pool{nullptr},
+         m_current{nullptr}, m_capacity{firstCapacity},
+         m_firstCapacity{firstCapacity}, m_allocated{}, m_blocks{},
+         m_free{nullptr} {
+            m_pool = ::operator new (m_capacity * m_slotSize,
+               std::align_val_t{m_align});
+            m_current = static_cast<char*>(m_pool);
+      }
+
+      // Деструктор
+      ~Region() {
+         for (void* block : m_blocks) {
+            ::operator delete (block, std::align_val_t{m_align});
+         }
+         ::operator delete (m_pool, std::align_val_t{m_align});
+      }
+
+      // Переход к следующему блоку цепочки ёмкостью не меньше n мест.
+      // Ёмкость растёт вдвое, поэтому выделение остаётся в среднем O(1)
+      void grow(std::size_t n) {
+         // Место в списке готовится заранее: после выделения блока
+         // исключений уже нет
+         m_blocks.reserve(m_blocks.size() + 1);
+         std::size_t next{std::max(m_capacity * 2, n)};
+         void* block = ::operator new (next * m_slotSize,
+            std::align_val_t{m_align});
+         m_blocks.push_back(m_pool);
+         m_pool = block;
+         m_current = static_cast<char*>(m_pool);
+         m_capacity = next;
+         m_allocated = 0;
+      }
+
+      // Возврат всех мест области: остаётся только первый блок
+      void reset() noexcept {
+         if (!m_blocks.empty()) {
+            ::operator delete (m_pool, std::align_val_t{m_align});
+            for (std::size_t i{1}; i < m_blocks.size(); ++i) {
+               ::operator delete (m_blocks[i], std::align_val_t{m_align});
+            }
+            m_pool = m_blocks.front();
+            m_blocks.clear();
+            m_capacity = m_firstCapacity;
+         }
+         m_current = static_cast<char*>(m_pool);
+         m_allocated = 0;
+         m_free = nullptr;
+      }
+
+      // Число блоков области
+      std::size_t blocks() const noexcept {
+         return m_blocks.size() + 1;
       }
 
       // Копирующий конструктор запрещён
-      Memory(const Memory&) = delete;
+      Region(const Region&) = delete;
 
       // Конструктор копирующего присваивания запрещён
-      Memory& operator=(const Memory&) = delete;
+      Region& operator=(const Region&) = delete;
+   };
+private:
+   std::vector<std::unique_ptr<Region>> m_regions; // Области классов размера
+   std::size_t m_capacity;  // Число мест в первом блоке каждой области
+public:
+   [[no_unique_address]] Stats m_stats;  // Статистика пула
 
-      // Перемещающий конструктор запрещён
-      Memory(Memory&&) = delete;
+   // Конструктор: память не резервируется до первого выделения
+   explicit StatefulPool(std::size_t firstCapacity = capacity) noexcept
+      : m_regions{}, m_capacity{firstCapacity}, m_stats{} {}
 
-      // Конструктор перемещающего присваивания
-      Memory& operator=(Memory&&) = delete;
-   };
+   // Деструктор
+   ~StatefulPool() {
+      m_stats.released();
+   }
+
+   // Копирующий конструктор запрещён
+   StatefulPool(const StatefulPool&) = delete;
+
+   // Конструктор копирующего присваивания запрещён
+   StatefulPool& operator=(const StatefulPool&) = delete;
+
+   // Область мест размера slotSize с выравниванием align, заводится при
+   // первом обращении. Классов размера у одного пула единицы, поэтому
+   // достаточно просмотра списка
+   Region& region(std::size_t slotSize, std::size_t align) {
+      for (const auto& region : m_regions) {
+         if (region->m_slotSize == slotSize && region->m_align == align) {
+            return *region;
+         }
+      }
+      m_regions.reserve(m_regions.size() + 1);
+      m_regions.push_back(std::make_unique<Region>(slotSize, align, m_capacity));
+      m_stats.block(m_capacity * slotSize);
+      return *m_regions.back();
+   }
+
+   // Выделение n подряд идущих мест области. Одно место сначала берётся
+   // из списка освобождённых, затем из текущего блока
+   void* allocate(Region& area, std::size_t n) {
+      if (n == 1 && area.m_free) {
+         void* slot = area.m_free;
+         std::memcpy(&area.m_free, slot, sizeof(void*));
+         m_stats.allocated(area.m_slotSize);
+         return slot;
+      }
+      if (area.m_allocated + n > area.m_capacity) {
+         if constexpr (expandable) {
+            area.grow(n);
+            m_stats.block(area.m_capacity * area.m_slotSize);
+         }
+         else {
+            m_stats.failed();
+            std::cerr << "Ошибка: недостаточно памяти!\n";
+            throw std::bad_alloc{};
+         }
+      }
+      void* slot = area.m_current;
+      area.m_current += n * area.m_slotSize;
+      area.m_allocated += n;
+      m_stats.allocated(n * area.m_slotSize);
+      return slot;
+   }
+
+   // Возврат n мест области: места размером не меньше указателя
+   // добавляются в начало списка освобождённых
+   void deallocate(Region& area, void* p, std::size_t n) noexcept {
+      m_stats.deallocated(n * area.m_slotSize);
+      if (area.m_slotSize < sizeof(void*)) return;
+      for (std::size_t i{}; i < n; ++i) {
+         void* slot = static_cast<char*>(p) + i * area.m_slotSize;
+         std::memcpy(slot, &area.m_free, sizeof(void*));
+         area.m_free = slot;
+      }
+   }
+
+   // Возврат всех мест всех областей, у каждой остаётся первый блок
+   void release() noexcept {
+      for (const auto& region : m_regions) {
+         region->reset();
+      }
+   }
+
+   // Число областей
+   std::size_t regions() const noexcept {
+      return m_regions.size();
+   }
+
+   // Число блоков всех областей
+   std::size_t blocks() const noexcept {
+      std::size_t count{};
+      for (const auto& region : m_regions) {
+         count += region->blocks();
+      }
+      return count;
+   }
+};
+
+// capacity -- число элементов первого блока.
+// expandable = false -- ёмкость фиксирована, попытка выделить больше
+// capacity элементов считается ошибкой.
+// expandable = true -- при исчерпании блока выделяется следующий блок
+// вдвое большей ёмкости. Прежние блоки не перемещаются, поэтому указатели
+// на размещённые элементы остаются действительными; все блоки
+// освобождаются вместе с последней копией аллокатора.
+// Копии и rebind-версии аллокатора делят один пул StatefulPool, и
+// блоки резервируются только для типов, которые действительно выделяют
+// память. Освобождённые элементы размером не меньше указателя собираются в
+// односвязный список внутри самих мест и отдаются allocate(1) первыми.
+// Stats -- политика статистики пула (alloc_stats.hpp): NoStats ничего не
+// считает, AllocStats ведёт счётчики, доступные через stats()
+template<typename T, std::size_t capacity, bool expandable = false,
+   typename Stats = NoStats>
+class StatefulAllocator {
+public:
+   using value_type = T;
+   using propagate_on_container_copy_assignment = std::true_type;
+   using propagate_on_container_move_assignment = std::true_type;
+   using propagate_on_container_swap = std::true_type;
+private:
+   using Memory = StatefulPool<capacity, expandable, Stats>;
+   using Region = typename Memory::Region;
 
    std::shared_ptr<Memory> memory;
+   Region* m_region; // Область мест типа T, nullptr -- ещё не найдена
+
+   template<typename U, std::size_t, bool, typename>
+   friend class StatefulAllocator;
+
+   // Область мест типа T в общем пуле
+   Region& region() {
+      if (!m_region) m_region = &memory->region(sizeof(T), alignof(T));
+      return *m_region;
+   }
 public:
    // Конструктор по умолчанию
-   StatefulAllocator() noexcept
-      : memory{std::make_shared<Memory>(capacity)} {}
+   StatefulAllocator()
+      : memory{std::make_shared<Memory>()}, m_region{nullptr} {}
 
    // Копирующий конструктор
    StatefulAllocator(const StatefulAllocator&) noexcept = default;
 
+   // Конструктор rebind-версии: тот же пул
+   template<typename U>
+   StatefulAllocator(const StatefulAllocator<U, capacity, expandable, Stats>& other) noexcept
+      : memory{other.memory}, m_region{nullptr} {}
+
    // Конструктор копирующего присваивания
    StatefulAllocator& operator=(const StatefulAllocator&) noexcept = default;
 
@@ -77,36 +265,49 @@ public:
       p->~U();
    }
 
-   // Функция alocate
+   // Функция alocate: сначала повторно используется освобождённое место
    T* allocate(std::size_t n) {
-      if (!memory or memory->m_allocated + n > memory->m_capacity) {
+      if (!memory) {
          std::cerr << "Ошибка: недостаточно памяти!\n";
          throw std::bad_alloc{};
       }
-      auto ptr = memory->m_current;
-      memory->m_current += n;
-      memory->m_allocated += n;
-      return ptr;
+      return static_cast<T*>(memory->allocate(region(), n));
    }
 
-   // Функция deallocate
-   void deallocate(T*, std::size_t) noexcept {}
+   // Функция deallocate: места добавляются в начало списка свободных
+   void deallocate(T* p, std::size_t n) noexcept {
+      if (!memory) return;
+      // Место выдано этой областью, значит она уже заведена в пуле
+      // и поиск не выделяет память
+      memory->deallocate(region(), p, n);
+   }
 
    // Метафункция rebind
    template<typename U>
    struct rebind {
-      using other = StatefulAllocator<U, capacity>;
+      using other = StatefulAllocator<U, capacity, expandable, Stats>;
    };
 
-   // Перегруженный operator=
+   // Статистика пула, есть только у аллокатора с политикой AllocStats.
+   // Копии и rebind-версии аллокатора делят пул и его статистику
+   const Stats& stats() const noexcept requires Stats::enabled {
+      return memory->m_stats;
+   }
+
+   // Число областей классов размера в пуле
+   std::size_t regions() const noexcept {
+      return memory ? memory->regions() : 0;
+   }
+
+   // Перегруженный operator==: аллокаторы с одним пулом взаимозаменяемы
    template<typename U>
-   bool operator=(const StatefulAllocator<U, capacity>& other) const noexcept {
+   bool operator==(const StatefulAllocator<U, capacity, expandable, Stats>& other) const noexcept {
       return memory == other.memory;
    }
 
    // Перегруженный operator!=
    template<typename U>
-   bool operator!=(const StatefulAllocator<U, capacity>& other) const noexcept {
-      return (*this == other);
+   bool operator!=(const StatefulAllocator<U, capacity, expandable, Stats>& other) const noexcept {
+      return !(*this == other);
    }
-};
\ No newline at end of file
+};
@@ -0,0 +1,358 @@
+#include <gtest/gtest.h>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory_resource>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../cust_alloc.hpp"       // Аллокатор с фиксированным блоком
+#include "../stateful_alloc.hpp"   // Аллокатор с общим пулом
+#include "../concurrent_alloc.hpp" // Пул, общий для нескольких потоков
+#include "../chunk_list.hpp"       // Контейнер из блоков элементов
+#include "../arena_resource.hpp"   // Ресурсы std::pmr над общей областью
+
+using Pair = std::pair<const int, int>;
+
+// Тесты расширяемого пула StatefulAllocator
+TEST(StatefulAllocatorTest, GrowthKeepsPointers)
+{
+   std::map<int, int, std::less<int>, StatefulAllocator<Pair, 4, true>> map{};
+   std::vector<const int*> values{};
+   for (int i{}; i < 1000; ++i) {
+      map[i] = i * 2;
+      values.push_back(&map.at(i));
+   }
+   for (int i{}; i < 1000; ++i) {
+      ASSERT_EQ(i * 2, *values[static_cast<std::size_t>(i)]);
+   }
+}
+
+TEST(StatefulAllocatorTest, FixedCapacityThrows)
+{
+   std::map<int, int, std::less<int>, StatefulAllocator<Pair, 4>> map{};
+   for (int i{}; i < 4; ++i) map[i] = i;
+   ASSERT_THROW(map[4] = 4, std::bad_alloc);
+}
+
+// Тесты повторного использования освобождённых мест
+TEST(FreeListTest, StatefulChurn)
+{
+   // Пул на 11 узлов выдерживает любое число пар вставка/удаление
+   std::map<int, int, std::less<int>, StatefulAllocator<Pair, 11>> map{};
+   for (int i{}; i < 10; ++i) map[i] = i;
+   for (int i{}; i < 100000; ++i) {
+      map[i + 10] = i;
+      map.erase(i);
+   }
+   ASSERT_EQ(10u, map.size());
+   ASSERT_EQ(100000, map.begin()->first);
+}
+
+TEST(FreeListTest, CustReusesLastFreed)
+{
+   CustAllocator<long, 4> allocator{};
+   long* first{allocator.allocate(1)};
+   long* second{allocator.allocate(1)};
+   allocator.deallocate(first, 1);
+   allocator.deallocate(second, 1);
+   // Последнее освобождённое место выдаётся первым
+   ASSERT_EQ(second, allocator.allocate(1));
+   ASSERT_EQ(first, allocator.allocate(1));
+}
+
+// Тесты пула, общего для нескольких потоков
+TEST(ConcurrentArenaTest, ReuseAndExhaustion)
+{
+   auto arena = std::make_shared<ConcurrentArena>(ConcurrentArena::slabSize);
+   ConcurrentAllocator<long> allocator{arena};
+   long* first{allocator.allocate(1)};
+   allocator.deallocate(first, 1);
+   ASSERT_EQ(first, allocator.allocate(1));
+   // Один слэб: места одного размера заканчиваются, второй слэб не выдаётся
+   ASSERT_THROW(
+      for (std::size_t i{}; i <= ConcurrentArena::slabSize / sizeof(long); ++i) {
+         allocator.allocate(1);
+      }, std::bad_alloc);
+   ASSERT_EQ(1u, arena->slabsUsed());
+}
+
+TEST(ConcurrentArenaTest, RebindSharesArena)
+{
+   auto arena = std::make_shared<ConcurrentArena>(std::size_t{1} << 20);
+   using Allocator = ConcurrentAllocator<Pair>;
+   std::map<int, int, std::less<int>, Allocator> map{Allocator{arena}};
+   for (int i{}; i < 100; ++i) map[i] = i;
+   ASSERT_TRUE(map.get_allocator() == Allocator{arena});
+   ASSERT_EQ(1u, arena->slabsUsed());
+}
+
+TEST(ConcurrentArenaTest, DeadArenaEntriesPruned)
+{
+   std::thread{[] {
+      // Записи уничтоженных областей не копятся в таблице потока
+      for (int i{}; i < 100; ++i) {
+         auto arena = std::make_shared<ConcurrentArena>(ConcurrentArena::slabSize);
+         ConcurrentAllocator<long> allocator{arena};
+         allocator.deallocate(allocator.allocate(1), 1);
+      }
+      EXPECT_EQ(1u, ConcurrentArena::threadCaches());
+   }}.join();
+}
+
+TEST(ConcurrentArenaTest, ForeignDeallocateCreatesNoCache)
+{
+   auto arena = std::make_shared<ConcurrentArena>(ConcurrentArena::slabSize);
+   ConcurrentAllocator<long> allocator{arena};
+   long* slot{allocator.allocate(1)};
+   std::thread{[&] {
+      // Поток без своего кеша возвращает место владельцу через стек
+      allocator.deallocate(slot, 1);
+      EXPECT_EQ(0u, ConcurrentArena::threadCaches());
+   }}.join();
+   ASSERT_EQ(slot, allocator.allocate(1));
+}
+
+// Нагрузочный тест (запускать и с -fsanitize=thread): рабочие потоки
+// строят свои map из общей области, затем удаляют часть элементов и
+// передают map соседу, который освобождает оставшиеся узлы из другого
+// потока. Освобождённые чужими потоками места возвращаются владельцу,
+// кеши завершившихся потоков переходят к потокам следующего раунда
+TEST(ConcurrentArenaTest, CrossThreadStress)
+{
+   constexpr int threads{4};
+   constexpr int rounds{20};
+   constexpr int keys{2000};
+   auto arena = std::make_shared<ConcurrentArena>(std::size_t{64} << 20);
+   using Allocator = ConcurrentAllocator<Pair>;
+   using Map = std::map<int, int, std::less<int>, Allocator>;
+
+   for (int round{}; round < rounds; ++round) {
+      std::vector<std::unique_ptr<Map>> maps(threads);
+      {
+         std::vector<std::jthread> workers{};
+         for (int t{}; t < threads; ++t) {
+            workers.emplace_back([&maps, &arena, t] {
+               auto map = std::make_unique<Map>(Allocator{arena});
+               for (int key{}; key < keys; ++key) {
+                  (*map)[key] = key + t;
+               }
+               for (int key{}; key < keys; key += 2) {
+                  map->erase(key);
+               }
+               maps[static_cast<std::size_t>(t)] = std::move(map);
+            });
+         }
+      }
+      {
+         std::vector<std::jthread> workers{};
+         for (int t{}; t < threads; ++t) {
+            // Поток t проверяет и уничтожает map соседа
+            workers.emplace_back([&maps, t] {
+               int owner{(t + 1) % threads};
+               auto map = std::move(maps[static_cast<std::size_t>(owner)]);
+               int expected{1};
+               for (const auto& [key, value] : *map) {
+                  EXPECT_EQ(expected, key);
+                  EXPECT_EQ(key + owner, value);
+                  expected += 2;
+               }
+               map.reset();
+            });
+         }
+      }
+   }
+   // Места возвращаются владельцам и используются повторно: память
+   // не растёт от раунда к раунду
+   ASSERT_LT(arena->slabsUsed(), std::size_t{threads} * 8);
+}
+
+// Тесты контейнера из блоков элементов
+TEST(ChunkListTest, KeepsOrderAcrossChunks)
+{
+   ChunkList<int, std::allocator<int>, 4> list{};
+   ASSERT_TRUE(list.empty());
+   for (int i{}; i < 10; ++i) list.push_back(i);
+   ASSERT_EQ(10u, list.size());
+   ASSERT_FALSE(list.empty());
+   std::vector<int> values(list.begin(), list.end());
+   ASSERT_EQ((std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}), values);
+}
+
+TEST(ChunkListTest, MoveTransfersElements)
+{
+   ChunkList<std::string, StatefulAllocator<std::string, 2>, 3> list{};
+   for (int i{}; i < 5; ++i) list.emplace_back(std::to_string(i));
+   auto moved{std::move(list)};
+   ASSERT_TRUE(list.empty());
+   ASSERT_EQ(list.begin(), list.end());
+   ASSERT_EQ(5u, moved.size());
+   decltype(moved) assigned{};
+   assigned.push_back("x");
+   assigned = std::move(moved);
+   ASSERT_EQ(5u, assigned.size());
+   ASSERT_EQ("4", *std::next(assigned.cbegin(), 4));
+}
+
+TEST(ChunkListTest, PoolCapacityCountsChunks)
+{
+   // CustAllocator на 2 блока по 5 элементов
+   ChunkList<int, CustAllocator<int, 2>, 5> list{};
+   for (int i{}; i < 10; ++i) list.push_back(i);
+   ASSERT_THROW(list.push_back(10), std::bad_alloc);
+   ASSERT_EQ(10u, list.size());
+   int sum{};
+   for (int value : list) sum += value;
+   ASSERT_EQ(45, sum);
+}
+
+TEST(ChunkListTest, AllocatorWithoutDefaultConstructor)
+{
+   auto arena = std::make_shared<ConcurrentArena>(std::size_t{1} << 20);
+   using Allocator = ConcurrentAllocator<int>;
+   ChunkList<int, Allocator, 4> list{Allocator{arena}};
+   for (int i{}; i < 10; ++i) list.push_back(i);
+   ASSERT_TRUE(list.get_allocator() == Allocator{arena});
+   ASSERT_EQ(1u, arena->slabsUsed());
+   auto moved{std::move(list)};
+   ASSERT_EQ(10u, moved.size());
+   ASSERT_EQ(9, *std::next(moved.begin(), 9));
+}
+
+// Тесты статистики аллокаторов
+TEST(AllocStatsTest, StatefulCountsAndPeak)
+{
+   using Allocator = StatefulAllocator<long, 4, true, AllocStats>;
+   Allocator allocator{};
+   long* values[6]{};
+   for (auto& value : values) value = allocator.allocate(1);
+   for (int i{}; i < 3; ++i) allocator.deallocate(values[i], 1);
+   allocator.allocate(1);
+   const AllocStats& stats = Allocator{allocator}.stats();
+   ASSERT_EQ(7u, stats.allocations);
+   ASSERT_EQ(3u, stats.deallocations);
+   ASSERT_EQ(4 * sizeof(long), stats.bytesInUse);
+   ASSERT_EQ(6 * sizeof(long), stats.peakBytes);
+   // Блоки на 4 и на 8 элементов
+   ASSERT_EQ(2u, stats.blocks);
+   ASSERT_EQ(12 * sizeof(long), stats.reservedBytes);
+   ASSERT_EQ(0u, stats.failures);
+}
+
+TEST(AllocStatsTest, CustCountsFailures)
+{
+   CustAllocator<long, 2, AllocStats> allocator{};
+   allocator.allocate(2);
+   ASSERT_THROW(allocator.allocate(1), std::bad_alloc);
+   ASSERT_EQ(1u, allocator.stats().failures);
+   ASSERT_EQ("{\"allocations\":1,\"deallocations\":0,\"failures\":1,"
+      "\"bytes_in_use\":16,\"peak_bytes\":16,\"blocks\":1,"
+      "\"reserved_bytes\":16}", allocator.stats().json());
+}
+
+TEST(AllocStatsTest, DisabledPolicyTakesNoSpace)
+{
+   // Статистика хранится в пуле, аллокатор без неё не больше
+   static_assert(sizeof(StatefulPool<4, false, NoStats>)
+      == sizeof(StatefulPool<4, false, AllocStats>) - sizeof(AllocStats));
+   static_assert(sizeof(CustAllocator<long, 4>) == sizeof(CustAllocator<long, 4, AllocStats>)
+      - sizeof(AllocStats));
+   SUCCEED();
+}
+
+// Тесты ресурсов std::pmr над общей областью
+TEST(ArenaResourceTest, ContainersShareArena)
+{
+   ArenaResource arena{std::size_t{1} << 16};
+   std::pmr::map<int, int> map{&arena};
+   std::pmr::vector<int> values{&arena};
+   for (int i{}; i < 100; ++i) {
+      map[i] = i;
+      values.push_back(i);
+   }
+   ASSERT_EQ(100u, map.size());
+   ASSERT_EQ(99, values.back());
+   ASSERT_EQ(1u, arena.pool().blocks());
+   ASSERT_THROW(values.resize(std::size_t{1} << 16), std::bad_alloc);
+}
+
+TEST(ArenaResourceTest, ExpandableAlignedAndRelease)
+{
+   ArenaResource<true> arena{64};
+   void* small{arena.allocate(8, 8)};
+   void* aligned{arena.allocate(100, 256)};
+   ASSERT_NE(small, aligned);
+   ASSERT_EQ(0u, reinterpret_cast<std::uintptr_t>(aligned) % 256);
+   ASSERT_EQ(2u, arena.pool().blocks());
+   // После release выделение снова идёт с начала первого блока
+   arena.release();
+   ASSERT_EQ(1u, arena.pool().blocks());
+   ASSERT_EQ(small, arena.allocate(8, 8));
+}
+
+TEST(PoolResourceTest, ReusesFreedSlots)
+{
+   PoolResource pool{std::size_t{1} << 12};
+   void* first{pool.allocate(40, 8)};
+   pool.deallocate(first, 40, 8);
+   // Тот же класс размера (33..48 байт)
+   ASSERT_EQ(first, pool.allocate(48, 8));
+   // Чередование вставки и удаления не расходует область
+   std::pmr::map<int, int> map{&pool};
+   for (int i{}; i < 100000; ++i) {
+      map[i] = i;
+      if (i >= 10) map.erase(i - 10);
+   }
+   ASSERT_EQ(10u, map.size());
+   ASSERT_EQ(1u, pool.pool().blocks());
+}
+
+// Тесты пула, общего для rebind-версий аллокатора
+TEST(SharedPoolTest, MapReservesOnlyNodes)
+{
+   using Allocator = StatefulAllocator<Pair, 10, false, AllocStats>;
+   Allocator allocator{};
+   std::map<int, int, std::less<int>, Allocator> map{allocator};
+   for (int i{}; i < 10; ++i) map[i] = i;
+   // Аллокатор std::pair и аллокатор узлов делят пул
+   ASSERT_TRUE(map.get_allocator() == allocator);
+   const AllocStats& stats = allocator.stats();
+   ASSERT_EQ(1u, allocator.regions());
+   ASSERT_EQ(1u, stats.blocks);
+   ASSERT_EQ(10u, stats.allocations);
+   // Блок рассчитан на узлы, а не на std::pair
+   ASSERT_EQ(0u, stats.reservedBytes % 10);
+   ASSERT_GT(stats.reservedBytes, 10 * sizeof(Pair));
+   ASSERT_EQ(stats.reservedBytes, stats.peakBytes);
+}
+
+TEST(SharedPoolTest, SizeClassesShareRegion)
+{
+   StatefulAllocator<long, 4> longs{};
+   StatefulAllocator<double, 4> doubles{longs};
+   StatefulAllocator<char, 4> chars{longs};
+   longs.allocate(2);
+   doubles.allocate(2);
+   // long и double одного размера: одна область на 4 места
+   ASSERT_EQ(1u, longs.regions());
+   ASSERT_THROW(doubles.allocate(1), std::bad_alloc);
+   chars.allocate(1);
+   ASSERT_EQ(2u, longs.regions());
+}
+
+TEST(SharedPoolTest, CustReservesOnFirstAllocate)
+{
+   CustAllocator<Pair, 10, AllocStats> allocator{};
+   ASSERT_EQ(0u, allocator.stats().blocks);
+   allocator.allocate(1);
+   ASSERT_EQ(1u, allocator.stats().blocks);
+}
+
+// Главная точка входа для запуска тестов
+int main(int argc, char **argv)
+{
+   ::testing::InitGoogleTest(&argc, argv);
+   return RUN_ALL_TESTS();
+}